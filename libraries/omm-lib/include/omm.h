@@ -291,6 +291,14 @@ typedef enum ommCpuTextureFlags
    // Controls the internal memory layout of the texture. does not change the expected input format, it does affect the baking
    // performance and memory footprint of the texture object.
    ommCpuTextureFlags_DisableZOrder = 1u << 0,
+   // Precomputes, per texel, the distance to the nearest texel on the other side of the embedded alphaCutoff. Micro-triangles
+   // far from any alpha edge are then classified without rasterization. Requires alphaCutoff, costs one byte per texel.
+   ommCpuTextureFlags_EnableCutoffDistance = 1u << 1,
+   // The texture references mips[].textureData instead of copying it. The memory must stay valid and unchanged until the
+   // texture is destroyed. Requires DisableZOrder, rowPitch is in bytes and must be a multiple of the texel size.
+   ommCpuTextureFlags_ReferenceTextureData = 1u << 2,
+   // Texture creation will use internal threads, as ommCpuBakeFlags_EnableInternalThreads does for baking.
+   ommCpuTextureFlags_EnableInternalThreads = 1u << 3,
 } ommCpuTextureFlags;
 OMM_DEFINE_ENUM_FLAG_OPERATORS(ommCpuTextureFlags);
 
@@ -453,6 +461,10 @@ typedef struct ommCpuBakeInputDesc
    // * Subdivision level of the OMMs.
    // Configure this value when experiencing long bake times, a starting point might be maxWorkloadSize = 1 << 28 (~ processing a total of 256 1k textures)
    uint64_t                 maxWorkloadSize;
+   // [optional] Snaps texture coordinates to a grid of texCoordQuantization texels of mip 0 before looking for primitives
+   // that can share an OMM, e.g. 1.f / 16.f. Primitives whose texture coordinates only differ within a grid cell then reuse
+   // the OMM baked for the first of them. <= 0: disabled, only bit-identical texture coordinates are shared.
+   float                    texCoordQuantization;
 } ommCpuBakeInputDesc;
 
 inline ommCpuBakeInputDesc ommCpuBakeInputDescDefault()
@@ -482,6 +494,7 @@ inline ommCpuBakeInputDesc ommCpuBakeInputDescDefault()
    v.maxArrayDataSize              = 0xFFFFFFFF;
    v.subdivisionLevels             = NULL;
    v.maxWorkloadSize               = 0xFFFFFFFFFFFFFFFF;
+   v.texCoordQuantization          = 0.f;
    return v;
 }
 
@@ -1169,6 +1182,8 @@ typedef struct ommDebugStats
    uint32_t totalFullyUnknownOpaque;
    uint32_t totalFullyUnknownTransparent;
    float knownAreaMetric; // this is known area in uv space, divided by the total uv space. -1.f if unknown
+   float threadUtilization; // busy time of the internal threads during resampling, divided by the time they were available. -1.f if unknown
+   float texCoordQuantization; // ommCpuBakeInputDesc::texCoordQuantization the primitives were matched with, 0 if disabled. -1.f if unknown
 } ommDebugStats;
 
 inline ommDebugStats ommDebugStatsDefault()
@@ -1183,6 +1198,8 @@ inline ommDebugStats ommDebugStatsDefault()
    v.totalFullyUnknownOpaque       = 0;
    v.totalFullyUnknownTransparent  = 0;
    v.knownAreaMetric               = 0;
+   v.threadUtilization             = -1.f;
+   v.texCoordQuantization          = -1.f;
    return v;
 }
 
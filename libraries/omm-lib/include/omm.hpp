@@ -202,6 +202,14 @@ namespace omm
          // Controls the internal memory layout of the texture. does not change the expected input format, it does affect the baking
          // performance and memory footprint of the texture object.
          DisableZOrder = 1u << 0,
+         // Precomputes, per texel, the distance to the nearest texel on the other side of the embedded alphaCutoff. Micro-triangles
+         // far from any alpha edge are then classified without rasterization. Requires alphaCutoff, costs one byte per texel.
+         EnableCutoffDistance = 1u << 1,
+         // The texture references mips[].textureData instead of copying it. The memory must stay valid and unchanged until the
+         // texture is destroyed. Requires DisableZOrder, rowPitch is in bytes and must be a multiple of the texel size.
+         ReferenceTextureData = 1u << 2,
+         // Texture creation will use internal threads, as BakeFlags::EnableInternalThreads does for baking.
+         EnableInternalThreads = 1u << 3,
       };
       OMM_DEFINE_ENUM_FLAG_OPERATORS(TextureFlags);
 
@@ -349,6 +357,10 @@ namespace omm
          // * Subdivision level of the OMMs.
          // Configure this value when experiencing long bake times, a starting point might be maxWorkloadSize = 1 << 28 (~ processing a total of 256 1k textures)
          uint64_t              maxWorkloadSize               = 0xFFFFFFFFFFFFFFFF;
+         // [optional] Snaps texture coordinates to a grid of texCoordQuantization texels of mip 0 before looking for primitives
+         // that can share an OMM, e.g. 1.f / 16.f. Primitives whose texture coordinates only differ within a grid cell then reuse
+         // the OMM baked for the first of them. <= 0: disabled, only bit-identical texture coordinates are shared.
+         float                 texCoordQuantization          = 0.f;
       };
 
       struct OpacityMicromapDesc
@@ -953,6 +965,8 @@ namespace omm
          uint32_t totalFullyUnknownOpaque       = 0;
          uint32_t totalFullyUnknownTransparent  = 0;
          float    knownAreaMetric               = -1.f;
+         float    threadUtilization             = -1.f;
+         float    texCoordQuantization          = -1.f;
       };
 
       static inline Result GetStats(Baker baker, const Cpu::BakeResultDesc* res, Stats* out);
@@ -344,13 +344,13 @@ OMM_API ommResult OMM_CALL ommDebugGetStats(ommBaker baker, const ommCpuBakeResu
     {
         Cpu::BakerImpl* impl = GetHandleImpl<Cpu::BakerImpl>(baker);
         StdAllocator<uint8_t>& memoryAllocator = (*impl).GetStdAllocator();
-        return GetStatsImpl(memoryAllocator, res, nullptr, out);
+        return GetStatsImpl(memoryAllocator, res, nullptr, -1.f /*threadUtilization*/, -1.f /*texCoordQuantization*/, out);
     }
     else if (GetHandleType(baker) == HandleType::GpuBaker)
     {
         Gpu::BakerImpl* impl = GetHandleImpl<Gpu::BakerImpl>(baker);
         StdAllocator<uint8_t>& memoryAllocator = (*impl).GetStdAllocator();
-        return GetStatsImpl(memoryAllocator, res, nullptr, out);
+        return GetStatsImpl(memoryAllocator, res, nullptr, -1.f /*threadUtilization*/, -1.f /*texCoordQuantization*/, out);
     }
     else
         return ommResult_INVALID_ARGUMENT;
@@ -369,17 +369,23 @@ OMM_API ommResult ommDebugGetStats2(ommBaker baker, ommCpuBakeResult res, ommDeb
     const float* area;
     RETURN_STATUS_IF_FAILED(resImpl->GetBakeResultAreaData(area));
 
+    float threadUtilization;
+    RETURN_STATUS_IF_FAILED(resImpl->GetBakeResultThreadUtilization(threadUtilization));
+
+    float texCoordQuantization;
+    RETURN_STATUS_IF_FAILED(resImpl->GetBakeResultTexCoordQuantization(texCoordQuantization));
+
     if (GetHandleType(baker) == HandleType::CpuBaker)
     {
         Cpu::BakerImpl* impl = GetHandleImpl<Cpu::BakerImpl>(baker);
         StdAllocator<uint8_t>& memoryAllocator = (*impl).GetStdAllocator();
-        return GetStatsImpl(memoryAllocator, desc, area, out);
+        return GetStatsImpl(memoryAllocator, desc, area, threadUtilization, texCoordQuantization, out);
     }
     else if (GetHandleType(baker) == HandleType::GpuBaker)
     {
         Gpu::BakerImpl* impl = GetHandleImpl<Gpu::BakerImpl>(baker);
         StdAllocator<uint8_t>& memoryAllocator = (*impl).GetStdAllocator();
-        return GetStatsImpl(memoryAllocator, desc, area, out);
+        return GetStatsImpl(memoryAllocator, desc, area, threadUtilization, texCoordQuantization, out);
     }
     else
         return ommResult_INVALID_ARGUMENT;
@@ -17,15 +17,21 @@ license agreement from NVIDIA CORPORATION is strictly prohibited.
 #include "util/bird.h"
 #include "util/cpu_raster.h"
 
+#define XXH_STATIC_LINKING_ONLY
 #include <xxhash.h>
 
 #include <random>
 #include <array>
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <cmath>
 #include <cstring>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace omm
 {
 namespace Cpu
@@ -142,6 +148,12 @@ namespace Cpu
         REGISTER_DISPATCH(ommCpuTextureFormat_FP32,TilingMode::MortonZ, ommTextureAddressMode_Border, ommTextureFilterMode_Linear, false);
         REGISTER_DISPATCH(ommCpuTextureFormat_FP32,TilingMode::MortonZ, ommTextureAddressMode_MirrorOnce, ommTextureFilterMode_Linear, false);
 
+        REGISTER_DISPATCH(ommCpuTextureFormat_FP32,TilingMode::BlockLinear, ommTextureAddressMode_Wrap, ommTextureFilterMode_Linear, false);
+        REGISTER_DISPATCH(ommCpuTextureFormat_FP32,TilingMode::BlockLinear, ommTextureAddressMode_Mirror, ommTextureFilterMode_Linear, false);
+        REGISTER_DISPATCH(ommCpuTextureFormat_FP32,TilingMode::BlockLinear, ommTextureAddressMode_Clamp, ommTextureFilterMode_Linear, false);
+        REGISTER_DISPATCH(ommCpuTextureFormat_FP32,TilingMode::BlockLinear, ommTextureAddressMode_Border, ommTextureFilterMode_Linear, false);
+        REGISTER_DISPATCH(ommCpuTextureFormat_FP32,TilingMode::BlockLinear, ommTextureAddressMode_MirrorOnce, ommTextureFilterMode_Linear, false);
+
         REGISTER_DISPATCH(ommCpuTextureFormat_FP32,TilingMode::Linear, ommTextureAddressMode_Wrap, ommTextureFilterMode_Nearest, false);
         REGISTER_DISPATCH(ommCpuTextureFormat_FP32,TilingMode::Linear, ommTextureAddressMode_Mirror, ommTextureFilterMode_Nearest, false);
         REGISTER_DISPATCH(ommCpuTextureFormat_FP32,TilingMode::Linear, ommTextureAddressMode_Clamp, ommTextureFilterMode_Nearest, false);
@@ -154,6 +166,12 @@ namespace Cpu
         REGISTER_DISPATCH(ommCpuTextureFormat_FP32,TilingMode::MortonZ, ommTextureAddressMode_Border, ommTextureFilterMode_Nearest, false);
         REGISTER_DISPATCH(ommCpuTextureFormat_FP32,TilingMode::MortonZ, ommTextureAddressMode_MirrorOnce, ommTextureFilterMode_Nearest, false);
 
+        REGISTER_DISPATCH(ommCpuTextureFormat_FP32,TilingMode::BlockLinear, ommTextureAddressMode_Wrap, ommTextureFilterMode_Nearest, false);
+        REGISTER_DISPATCH(ommCpuTextureFormat_FP32,TilingMode::BlockLinear, ommTextureAddressMode_Mirror, ommTextureFilterMode_Nearest, false);
+        REGISTER_DISPATCH(ommCpuTextureFormat_FP32,TilingMode::BlockLinear, ommTextureAddressMode_Clamp, ommTextureFilterMode_Nearest, false);
+        REGISTER_DISPATCH(ommCpuTextureFormat_FP32,TilingMode::BlockLinear, ommTextureAddressMode_Border, ommTextureFilterMode_Nearest, false);
+        REGISTER_DISPATCH(ommCpuTextureFormat_FP32,TilingMode::BlockLinear, ommTextureAddressMode_MirrorOnce, ommTextureFilterMode_Nearest, false);
+
         REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8, TilingMode::Linear, ommTextureAddressMode_Wrap, ommTextureFilterMode_Linear, false);
         REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8, TilingMode::Linear, ommTextureAddressMode_Mirror, ommTextureFilterMode_Linear, false);
         REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8, TilingMode::Linear, ommTextureAddressMode_Clamp, ommTextureFilterMode_Linear, false);
@@ -166,6 +184,12 @@ namespace Cpu
         REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8,TilingMode::MortonZ, ommTextureAddressMode_Border, ommTextureFilterMode_Linear, false);
         REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8,TilingMode::MortonZ, ommTextureAddressMode_MirrorOnce, ommTextureFilterMode_Linear, false);
 
+        REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8,TilingMode::BlockLinear, ommTextureAddressMode_Wrap, ommTextureFilterMode_Linear, false);
+        REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8,TilingMode::BlockLinear, ommTextureAddressMode_Mirror, ommTextureFilterMode_Linear, false);
+        REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8,TilingMode::BlockLinear, ommTextureAddressMode_Clamp, ommTextureFilterMode_Linear, false);
+        REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8,TilingMode::BlockLinear, ommTextureAddressMode_Border, ommTextureFilterMode_Linear, false);
+        REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8,TilingMode::BlockLinear, ommTextureAddressMode_MirrorOnce, ommTextureFilterMode_Linear, false);
+
         REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8,TilingMode::Linear, ommTextureAddressMode_Wrap, ommTextureFilterMode_Nearest, false);
         REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8,TilingMode::Linear, ommTextureAddressMode_Mirror, ommTextureFilterMode_Nearest, false);
         REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8,TilingMode::Linear, ommTextureAddressMode_Clamp, ommTextureFilterMode_Nearest, false);
@@ -178,6 +202,12 @@ namespace Cpu
         REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8,TilingMode::MortonZ, ommTextureAddressMode_Border, ommTextureFilterMode_Nearest, false);
         REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8,TilingMode::MortonZ, ommTextureAddressMode_MirrorOnce, ommTextureFilterMode_Nearest, false);
 
+        REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8,TilingMode::BlockLinear, ommTextureAddressMode_Wrap, ommTextureFilterMode_Nearest, false);
+        REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8,TilingMode::BlockLinear, ommTextureAddressMode_Mirror, ommTextureFilterMode_Nearest, false);
+        REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8,TilingMode::BlockLinear, ommTextureAddressMode_Clamp, ommTextureFilterMode_Nearest, false);
+        REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8,TilingMode::BlockLinear, ommTextureAddressMode_Border, ommTextureFilterMode_Nearest, false);
+        REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8,TilingMode::BlockLinear, ommTextureAddressMode_MirrorOnce, ommTextureFilterMode_Nearest, false);
+
 
         REGISTER_DISPATCH(ommCpuTextureFormat_FP32, TilingMode::Linear, ommTextureAddressMode_Wrap, ommTextureFilterMode_Linear, true);
         REGISTER_DISPATCH(ommCpuTextureFormat_FP32, TilingMode::Linear, ommTextureAddressMode_Mirror, ommTextureFilterMode_Linear, true);
@@ -191,6 +221,12 @@ namespace Cpu
         REGISTER_DISPATCH(ommCpuTextureFormat_FP32, TilingMode::MortonZ, ommTextureAddressMode_Border, ommTextureFilterMode_Linear, true);
         REGISTER_DISPATCH(ommCpuTextureFormat_FP32, TilingMode::MortonZ, ommTextureAddressMode_MirrorOnce, ommTextureFilterMode_Linear, true);
 
+        REGISTER_DISPATCH(ommCpuTextureFormat_FP32, TilingMode::BlockLinear, ommTextureAddressMode_Wrap, ommTextureFilterMode_Linear, true);
+        REGISTER_DISPATCH(ommCpuTextureFormat_FP32, TilingMode::BlockLinear, ommTextureAddressMode_Mirror, ommTextureFilterMode_Linear, true);
+        REGISTER_DISPATCH(ommCpuTextureFormat_FP32, TilingMode::BlockLinear, ommTextureAddressMode_Clamp, ommTextureFilterMode_Linear, true);
+        REGISTER_DISPATCH(ommCpuTextureFormat_FP32, TilingMode::BlockLinear, ommTextureAddressMode_Border, ommTextureFilterMode_Linear, true);
+        REGISTER_DISPATCH(ommCpuTextureFormat_FP32, TilingMode::BlockLinear, ommTextureAddressMode_MirrorOnce, ommTextureFilterMode_Linear, true);
+
         REGISTER_DISPATCH(ommCpuTextureFormat_FP32, TilingMode::Linear, ommTextureAddressMode_Wrap, ommTextureFilterMode_Nearest, true);
         REGISTER_DISPATCH(ommCpuTextureFormat_FP32, TilingMode::Linear, ommTextureAddressMode_Mirror, ommTextureFilterMode_Nearest, true);
         REGISTER_DISPATCH(ommCpuTextureFormat_FP32, TilingMode::Linear, ommTextureAddressMode_Clamp, ommTextureFilterMode_Nearest, true);
@@ -203,6 +239,12 @@ namespace Cpu
         REGISTER_DISPATCH(ommCpuTextureFormat_FP32, TilingMode::MortonZ, ommTextureAddressMode_Border, ommTextureFilterMode_Nearest, true);
         REGISTER_DISPATCH(ommCpuTextureFormat_FP32, TilingMode::MortonZ, ommTextureAddressMode_MirrorOnce, ommTextureFilterMode_Nearest, true);
 
+        REGISTER_DISPATCH(ommCpuTextureFormat_FP32, TilingMode::BlockLinear, ommTextureAddressMode_Wrap, ommTextureFilterMode_Nearest, true);
+        REGISTER_DISPATCH(ommCpuTextureFormat_FP32, TilingMode::BlockLinear, ommTextureAddressMode_Mirror, ommTextureFilterMode_Nearest, true);
+        REGISTER_DISPATCH(ommCpuTextureFormat_FP32, TilingMode::BlockLinear, ommTextureAddressMode_Clamp, ommTextureFilterMode_Nearest, true);
+        REGISTER_DISPATCH(ommCpuTextureFormat_FP32, TilingMode::BlockLinear, ommTextureAddressMode_Border, ommTextureFilterMode_Nearest, true);
+        REGISTER_DISPATCH(ommCpuTextureFormat_FP32, TilingMode::BlockLinear, ommTextureAddressMode_MirrorOnce, ommTextureFilterMode_Nearest, true);
+
         REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8, TilingMode::Linear, ommTextureAddressMode_Wrap, ommTextureFilterMode_Linear, true);
         REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8, TilingMode::Linear, ommTextureAddressMode_Mirror, ommTextureFilterMode_Linear, true);
         REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8, TilingMode::Linear, ommTextureAddressMode_Clamp, ommTextureFilterMode_Linear, true);
@@ -215,6 +257,12 @@ namespace Cpu
         REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8, TilingMode::MortonZ, ommTextureAddressMode_Border, ommTextureFilterMode_Linear, true);
         REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8, TilingMode::MortonZ, ommTextureAddressMode_MirrorOnce, ommTextureFilterMode_Linear, true);
 
+        REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8, TilingMode::BlockLinear, ommTextureAddressMode_Wrap, ommTextureFilterMode_Linear, true);
+        REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8, TilingMode::BlockLinear, ommTextureAddressMode_Mirror, ommTextureFilterMode_Linear, true);
+        REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8, TilingMode::BlockLinear, ommTextureAddressMode_Clamp, ommTextureFilterMode_Linear, true);
+        REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8, TilingMode::BlockLinear, ommTextureAddressMode_Border, ommTextureFilterMode_Linear, true);
+        REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8, TilingMode::BlockLinear, ommTextureAddressMode_MirrorOnce, ommTextureFilterMode_Linear, true);
+
         REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8, TilingMode::Linear, ommTextureAddressMode_Wrap, ommTextureFilterMode_Nearest, true);
         REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8, TilingMode::Linear, ommTextureAddressMode_Mirror, ommTextureFilterMode_Nearest, true);
         REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8, TilingMode::Linear, ommTextureAddressMode_Clamp, ommTextureFilterMode_Nearest, true);
@@ -226,6 +274,12 @@ namespace Cpu
         REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8, TilingMode::MortonZ, ommTextureAddressMode_Clamp, ommTextureFilterMode_Nearest, true);
         REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8, TilingMode::MortonZ, ommTextureAddressMode_Border, ommTextureFilterMode_Nearest, true);
         REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8, TilingMode::MortonZ, ommTextureAddressMode_MirrorOnce, ommTextureFilterMode_Nearest, true);
+
+        REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8, TilingMode::BlockLinear, ommTextureAddressMode_Wrap, ommTextureFilterMode_Nearest, true);
+        REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8, TilingMode::BlockLinear, ommTextureAddressMode_Mirror, ommTextureFilterMode_Nearest, true);
+        REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8, TilingMode::BlockLinear, ommTextureAddressMode_Clamp, ommTextureFilterMode_Nearest, true);
+        REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8, TilingMode::BlockLinear, ommTextureAddressMode_Border, ommTextureFilterMode_Nearest, true);
+        REGISTER_DISPATCH(ommCpuTextureFormat_UNORM8, TilingMode::BlockLinear, ommTextureAddressMode_MirrorOnce, ommTextureFilterMode_Nearest, true);
     }
 
     BakeOutputImpl::~BakeOutputImpl()
@@ -265,6 +319,8 @@ namespace Cpu
         {
             return m_log.InvalidArg("[Invalid Argument] - EnableNearDuplicateDetection or EnableNearDuplicateDetectionBruteForce is used together with DisableDuplicateDetection");
         }
+        if (!std::isfinite(desc.texCoordQuantization))
+            return m_log.InvalidArg("[Invalid Argument] - texCoordQuantization is not finite");
         if (options.enableValidation && !m_log.HasLogger())
             return m_log.InvalidArg("[Invalid Argument] - EnableValidation is set but no message callback was provided"); // this works more as documentation since it won't be logged
 
@@ -344,121 +400,582 @@ namespace Cpu
         }
     };
 
+    static uint32_t GetMaxThreadCount()
+    {
+#ifdef _OPENMP
+        return (uint32_t)omp_get_max_threads();
+#else
+        return 1;
+#endif
+    }
+
+    static uint32_t GetThreadIndex()
+    {
+#ifdef _OPENMP
+        return (uint32_t)omp_get_thread_num();
+#else
+        return 0;
+#endif
+    }
+
+    // Micro-triangle states are stored as 2-bit fields in bird-curve order, packed 32 per 64-bit word.
+    // Bit layout matches the OC1_4_State output format, so a word is 8 bytes of final array data.
     class OmmArrayDataView
     {
-        static void SetStateInternal(uint8_t* targetBuffer, uint32_t index, ommOpacityState state) {
-            targetBuffer[index] = (uint8_t)state;
+        friend class OmmArrayDataVector;
+
+        static constexpr uint32_t kStatesPerWord = 32;
+        static constexpr uint64_t kLowBitMask = 0x5555555555555555ull;
+
+        static void SetStateInternal(uint64_t* targetBuffer, uint32_t index, ommOpacityState state) {
+            uint64_t& word = targetBuffer[index / kStatesPerWord];
+            const uint64_t shift = (index % kStatesPerWord) << 1u;
+            word = (word & ~(3ull << shift)) | ((uint64_t)state << shift);
         }
 
-        static ommOpacityState GetStateInternal(const uint8_t* targetBuffer, uint32_t index) {
-            return (ommOpacityState)targetBuffer[index];
+        static ommOpacityState GetStateInternal(const uint64_t* targetBuffer, uint32_t index) {
+            const uint64_t shift = (index % kStatesPerWord) << 1u;
+            return (ommOpacityState)((targetBuffer[index / kStatesPerWord] >> shift) & 3ull);
+        }
+
+        template<class TGetWord>
+        static XXH128_hash_t Compute3StateDigestInternal(uint32_t numStates, uint64_t seed, TGetWord&& getWord) {
+            static constexpr size_t kBatchSize = 64;
+            uint64_t batch[kBatchSize];
+
+            // The state count is part of the seed to separate arrays that share a word count.
+            seed ^= (uint64_t)numStates * 0x9E3779B97F4A7C15ull;
+
+            const size_t wordCount = GetWordCount(numStates);
+            if (wordCount <= kBatchSize)
+            {
+                for (size_t i = 0; i < wordCount; ++i)
+                    batch[i] = To3State(getWord(i));
+                return XXH3_128bits_withSeed((const void*)batch, wordCount * sizeof(uint64_t), seed);
+            }
+
+            XXH3_state_t state;
+            XXH3_128bits_reset_withSeed(&state, seed);
+            for (size_t offset = 0; offset < wordCount; offset += kBatchSize)
+            {
+                const size_t count = std::min(kBatchSize, wordCount - offset);
+                for (size_t i = 0; i < count; ++i)
+                    batch[i] = To3State(getWord(offset + i));
+                XXH3_128bits_update(&state, (const void*)batch, count * sizeof(uint64_t));
+            }
+            return XXH3_128bits_digest(&state);
         }
 
     public:
         OmmArrayDataView() = delete;
-        OmmArrayDataView(ommFormat format, uint8_t* data, uint8_t* data3state, size_t ommArrayDataSize)
+        OmmArrayDataView(ommFormat format, uint64_t* data, uint32_t numStates)
             : _is2State(format == ommFormat_OC1_2_State),
-             _ommArrayData4or2state(data),
-             _ommArrayData3state(data3state),
-             _ommArrayDataSize(ommArrayDataSize) 
+             _ommArrayData(data),
+             _numStates(numStates)
         {
             OMM_ASSERT(format == ommFormat_OC1_2_State || format == ommFormat_OC1_4_State);
         }
 
-        void SetData(uint8_t* data, uint8_t* data3state, size_t size) {
-            _ommArrayData4or2state = data;
-            _ommArrayData3state = data3state;
-            _ommArrayDataSize = size;
+        static size_t GetWordCount(uint32_t numStates) { return math::DivUp<size_t>(numStates, kStatesPerWord); }
+
+        // UnknownTransparent (0b10) -> UnknownOpaque (0b11), applied to all 32 fields of a word at once.
+        static uint64_t To3State(uint64_t word) { return word | ((word >> 1ull) & kLowBitMask); }
+
+        // A word with all 32 fields set to state.
+        static uint64_t FillWord(ommOpacityState state) { return (uint64_t)state * kLowBitMask; }
+
+        // Unused fields of the last word are kept as UnknownOpaque so that digests and compares can work on whole words.
+        static uint64_t PadLastWord(uint64_t word, uint32_t numStates) {
+            const uint32_t numUsedBits = (numStates * 2u) & 63u;
+            return numUsedBits == 0 ? word : word | (~0ull << numUsedBits);
+        }
+
+        void SetData(uint64_t* data, uint32_t numStates) {
+            _ommArrayData = data;
+            _numStates = numStates;
         }
 
         void SetState(uint32_t index, ommOpacityState state) {
-            SetStateInternal(_ommArrayData4or2state, index, state);
-            SetStateInternal(_ommArrayData3state, index, state == ommOpacityState_UnknownTransparent ? ommOpacityState_UnknownOpaque : state);
+            OMM_ASSERT(index < _numStates);
+            SetStateInternal(_ommArrayData, index, state);
         }
 
         ommOpacityState GetState(uint32_t index) const {
-            return GetStateInternal(_ommArrayData4or2state, index);
+            OMM_ASSERT(index < _numStates);
+            return GetStateInternal(_ommArrayData, index);
         }
 
         ommOpacityState Get3State(uint32_t index) const {
-            return GetStateInternal(_ommArrayData3state, index);
+            const ommOpacityState state = GetState(index);
+            return state == ommOpacityState_UnknownTransparent ? ommOpacityState_UnknownOpaque : state;
+        }
+
+        void Fill(ommOpacityState state) {
+            const size_t wordCount = GetWordCount();
+            std::fill(_ommArrayData, _ommArrayData + wordCount, FillWord(state));
+            _ommArrayData[wordCount - 1] = PadLastWord(_ommArrayData[wordCount - 1], _numStates);
         }
 
-        uint8_t* GetOmm3StateData() const { return _ommArrayData3state; }
-        size_t GetOmm3StateDataSize() const { return _ommArrayDataSize;  }
+        // Sets the states in [begin, end), whole words are written at once.
+        void FillRange(uint32_t begin, uint32_t end, ommOpacityState state) {
+            OMM_ASSERT(begin <= end && end <= _numStates);
+            for (; begin < end && (begin % kStatesPerWord) != 0; ++begin)
+                SetStateInternal(_ommArrayData, begin, state);
+
+            const uint64_t word = FillWord(state);
+            for (; begin + kStatesPerWord <= end; begin += kStatesPerWord)
+                _ommArrayData[begin / kStatesPerWord] = word;
+
+            for (; begin < end; ++begin)
+                SetStateInternal(_ommArrayData, begin, state);
+        }
+
+        bool IsUniform(ommOpacityState& outState) const {
+            outState = GetState(0);
+            const uint64_t word = FillWord(outState);
+            const size_t wordCount = GetWordCount();
+            for (size_t i = 0; i < wordCount - 1; ++i)
+            {
+                if (_ommArrayData[i] != word)
+                    return false;
+            }
+            return _ommArrayData[wordCount - 1] == PadLastWord(word, _numStates);
+        }
+
+        uint64_t* GetData() { return _ommArrayData; }
+        const uint64_t* GetData() const { return _ommArrayData; }
+        size_t GetWordCount() const { return GetWordCount(_numStates); }
+        uint32_t GetNumStates() const { return _numStates; }
+
+        // Digest of the 3-state data, i.e. UnknownTransparent and UnknownOpaque hash the same.
+        XXH128_hash_t Compute3StateDigest(uint64_t seed) const {
+            return Compute3StateDigestInternal(_numStates, seed, [this](size_t i) { return _ommArrayData[i]; });
+        }
 
     private:
         bool _is2State;
-        uint8_t* _ommArrayData4or2state;
-        uint8_t* _ommArrayData3state;
-        size_t _ommArrayDataSize;
+        uint64_t* _ommArrayData;
+        uint32_t _numStates;
     };
 
-    class OmmArrayDataVector final : public OmmArrayDataView
+    // Hands out packed state storage from per-thread slabs, one slab chain per subdivision level so all blocks of a
+    // chain have the same size. Released blocks go to a per-thread free list, slabs are only freed with the pool.
+    class OmmArrayDataPool
     {
+        static constexpr size_t kSlabSizeInWords = 1ull << 15ull; // 256 KB
+
+        struct Level
+        {
+            uint64_t* begin = nullptr;
+            uint64_t* end = nullptr;
+            uint64_t* freeList = nullptr; // Intrusive, the first word of a free block links to the next.
+        };
+
+        struct alignas(kCacheLineSize) ThreadCache
+        {
+            ThreadCache(const StdAllocator<uint8_t>& stdAllocator) : slabs(stdAllocator), scratch(stdAllocator) { }
+
+            vector<uint64_t*> slabs;
+            vector<uint64_t> scratch;
+            Level levels[kMaxNumSubdivLevels];
+        };
+
+        ThreadCache& GetThreadCache() {
+            // Outside of the internal parallel regions a caller thread may report any index, clamping is safe there
+            // as nothing else touches the pool concurrently.
+            return _threads[std::min<uint32_t>(GetThreadIndex(), (uint32_t)_threads.size() - 1)];
+        }
+
     public:
-        OmmArrayDataVector() = delete;
-        OmmArrayDataVector(const StdAllocator<uint8_t>& stdAllocator, ommFormat format, uint32_t subdivisionLevel)
-            : OmmArrayDataView(format, nullptr, nullptr, 0)
-            , data(stdAllocator.GetInterface())
-            , data3state(stdAllocator.GetInterface())
+        OmmArrayDataPool(const StdAllocator<uint8_t>& stdAllocator, bool enableInternalThreads)
+            : _stdAllocator(stdAllocator)
+            , _threads(stdAllocator)
         {
-            const size_t maxSizeInBytes = (size_t)omm::bird::GetNumMicroTriangles(subdivisionLevel);
-            data.resize(maxSizeInBytes);
-            data3state.resize(maxSizeInBytes);
-            OmmArrayDataView::SetData((uint8_t*)data.data(), data3state.data(), maxSizeInBytes);
-            Init();
+            const uint32_t numThreads = enableInternalThreads ? GetMaxThreadCount() : 1;
+            _threads.reserve(numThreads);
+            for (uint32_t i = 0; i < numThreads; ++i)
+                _threads.emplace_back(stdAllocator);
         }
 
-        void ShrinkTo(uint32_t subdivisionLevel)
+        OmmArrayDataPool(const OmmArrayDataPool&) = delete;
+        OmmArrayDataPool& operator=(const OmmArrayDataPool&) = delete;
+
+        ~OmmArrayDataPool()
+        {
+            for (ThreadCache& thread : _threads)
+            {
+                for (uint64_t* slab : thread.slabs)
+                    _stdAllocator.deallocate(slab, 0);
+            }
+        }
+
+        static size_t GetWordCount(uint32_t subdivisionLevel) {
+            return OmmArrayDataView::GetWordCount(omm::bird::GetNumMicroTriangles(subdivisionLevel));
+        }
+
+        uint64_t* Allocate(uint32_t subdivisionLevel)
+        {
+            OMM_ASSERT(subdivisionLevel < kMaxNumSubdivLevels);
+            ThreadCache& thread = GetThreadCache();
+            Level& level = thread.levels[subdivisionLevel];
+
+            if (level.freeList != nullptr)
+            {
+                uint64_t* block = level.freeList;
+                std::memcpy(&level.freeList, block, sizeof(uint64_t*));
+                return block;
+            }
+
+            const size_t wordCount = GetWordCount(subdivisionLevel);
+            if (level.begin + wordCount > level.end)
+            {
+                // Word counts are powers of two, the slab holds a whole number of blocks.
+                const size_t slabSize = std::max(kSlabSizeInWords, wordCount);
+                uint64_t* slab = _stdAllocator.allocate(slabSize, kCacheLineSize);
+                OMM_ASSERT(slab != nullptr);
+                thread.slabs.push_back(slab);
+                level.begin = slab;
+                level.end = slab + slabSize;
+            }
+
+            uint64_t* block = level.begin;
+            level.begin += wordCount;
+            return block;
+        }
+
+        void Release(uint32_t subdivisionLevel, uint64_t* block)
         {
-            const size_t maxSizeInBytes = (size_t)omm::bird::GetNumMicroTriangles(subdivisionLevel);
+            Level& level = GetThreadCache().levels[subdivisionLevel];
+            std::memcpy(block, &level.freeList, sizeof(uint64_t*));
+            level.freeList = block;
+        }
 
-            assert(maxSizeInBytes < data.size());
-            assert(maxSizeInBytes < data3state.size());
-            data.resize(maxSizeInBytes);
-            data3state.resize(maxSizeInBytes);
+        // Thread local staging buffer, valid until the next call on the same thread.
+        OmmArrayDataView GetScratch(ommFormat format, uint32_t numStates)
+        {
+            ThreadCache& thread = GetThreadCache();
+            const size_t wordCount = OmmArrayDataView::GetWordCount(numStates);
+            if (thread.scratch.size() < wordCount)
+                thread.scratch.resize(wordCount);
+            return OmmArrayDataView(format, thread.scratch.data(), numStates);
         }
 
     private:
+        StdAllocator<uint64_t> _stdAllocator;
+        vector<ThreadCache> _threads;
+    };
+
+    // Packed states of a work item. Storage is only taken from the pool once the states stop being uniform,
+    // until then all micro-triangles share _uniformState.
+    class OmmArrayDataVector final
+    {
+    public:
+        OmmArrayDataVector() = delete;
+        OmmArrayDataVector(OmmArrayDataPool& pool, ommFormat format, uint32_t subdivisionLevel)
+            : _pool(&pool)
+            , _data(nullptr)
+            , _format(format)
+            , _allocationLevel(subdivisionLevel)
+            , _numStates(omm::bird::GetNumMicroTriangles(subdivisionLevel))
+            , _uniformState(ommOpacityState_UnknownOpaque)
+        {
+            OMM_ASSERT(format == ommFormat_OC1_2_State || format == ommFormat_OC1_4_State);
+        }
+
+        void SetState(uint32_t index, ommOpacityState state) {
+            OMM_ASSERT(index < _numStates);
+            if (_data == nullptr)
+            {
+                if (state == _uniformState)
+                    return;
+                _data = _pool->Allocate(_allocationLevel);
+                OmmArrayDataView(_format, _data, _numStates).Fill(_uniformState);
+            }
+            OmmArrayDataView::SetStateInternal(_data, index, state);
+        }
+
+        ommOpacityState GetState(uint32_t index) const {
+            OMM_ASSERT(index < _numStates);
+            return _data == nullptr ? _uniformState : OmmArrayDataView::GetStateInternal(_data, index);
+        }
+
+        ommOpacityState Get3State(uint32_t index) const {
+            const ommOpacityState state = GetState(index);
+            return state == ommOpacityState_UnknownTransparent ? ommOpacityState_UnknownOpaque : state;
+        }
+
+        bool IsUniform(ommOpacityState& outState) const {
+            if (_data == nullptr)
+            {
+                outState = _uniformState;
+                return true;
+            }
+            return OmmArrayDataView(_format, _data, _numStates).IsUniform(outState);
+        }
+
+        // Copies the states to a thread local buffer, resampling writes there and hands it back to Commit.
+        // Items that end up uniform never touch the pool.
+        OmmArrayDataView Stage() const {
+            OmmArrayDataView states = _pool->GetScratch(_format, _numStates);
+            if (_data == nullptr)
+                states.Fill(_uniformState);
+            else
+                std::memcpy(states.GetData(), _data, states.GetWordCount() * sizeof(uint64_t));
+            return states;
+        }
+
+        void Commit(const OmmArrayDataView& states) {
+            OMM_ASSERT(states.GetNumStates() == _numStates);
+            ommOpacityState uniformState;
+            if (states.IsUniform(uniformState))
+            {
+                if (_data != nullptr)
+                    _pool->Release(_allocationLevel, _data);
+                _data = nullptr;
+                _uniformState = uniformState;
+                return;
+            }
+
+            if (_data == nullptr)
+                _data = _pool->Allocate(_allocationLevel);
+            std::memcpy(_data, states.GetData(), states.GetWordCount() * sizeof(uint64_t));
+        }
 
-        void Init()
+        // Direct access to the storage, so that disjoint word ranges can be resampled by several threads at once.
+        // Follow up with Compact once all writers are done.
+        OmmArrayDataView Materialize() {
+            if (_data == nullptr)
+            {
+                _data = _pool->Allocate(_allocationLevel);
+                OmmArrayDataView(_format, _data, _numStates).Fill(_uniformState);
+            }
+            return OmmArrayDataView(_format, _data, _numStates);
+        }
+
+        // Hands the storage back to the pool if the states ended up uniform.
+        void Compact() {
+            ommOpacityState uniformState;
+            if (_data != nullptr && OmmArrayDataView(_format, _data, _numStates).IsUniform(uniformState))
+            {
+                _pool->Release(_allocationLevel, _data);
+                _data = nullptr;
+                _uniformState = uniformState;
+            }
+        }
+
+        void ShrinkTo(uint32_t subdivisionLevel)
         {
-            std::fill(data.begin(), data.end(), ommOpacityState_UnknownOpaque);
-            std::fill(data3state.begin(), data3state.end(), ommOpacityState_UnknownOpaque);
+            const uint32_t numStates = omm::bird::GetNumMicroTriangles(subdivisionLevel);
+            OMM_ASSERT(numStates < _numStates);
+            _numStates = numStates;
+
+            // The block keeps its size, only the padding of the new last word needs fixing up.
+            if (_data != nullptr)
+                _data[GetWordCount() - 1] = OmmArrayDataView::PadLastWord(_data[GetWordCount() - 1], _numStates);
+        }
+
+        uint64_t GetWord(size_t i) const {
+            if (_data != nullptr)
+                return _data[i];
+            const uint64_t word = OmmArrayDataView::FillWord(_uniformState);
+            return i + 1 == GetWordCount() ? OmmArrayDataView::PadLastWord(word, _numStates) : word;
+        }
+
+        // Returns byte i of the packed 4-state data.
+        uint8_t GetByte(size_t i) const { return (uint8_t)(GetWord(i >> 3ull) >> ((i & 7ull) << 3ull)); }
+
+        size_t GetWordCount() const { return OmmArrayDataView::GetWordCount(_numStates); }
+        uint32_t GetNumStates() const { return _numStates; }
+
+        // Digest of the 3-state data, identical for uniform and allocated storage holding the same states.
+        XXH128_hash_t Compute3StateDigest(uint64_t seed) const {
+            return OmmArrayDataView::Compute3StateDigestInternal(_numStates, seed, [this](size_t i) { return GetWord(i); });
+        }
+
+        // True when both hold the same 3-state data, the counterpart of Compute3StateDigest.
+        bool Is3StateEqual(const OmmArrayDataVector& other) const {
+            if (_numStates != other._numStates)
+                return false;
+            if (_data == nullptr && other._data == nullptr)
+                return OmmArrayDataView::To3State(OmmArrayDataView::FillWord(_uniformState)) == OmmArrayDataView::To3State(OmmArrayDataView::FillWord(other._uniformState));
+            for (size_t i = 0; i < GetWordCount(); ++i)
+            {
+                if (OmmArrayDataView::To3State(GetWord(i)) != OmmArrayDataView::To3State(other.GetWord(i)))
+                    return false;
+            }
+            return true;
+        }
+
+        // Number of states that differ after mapping to 3-state, 32 states are compared per word.
+        uint32_t HammingDistance3State(const OmmArrayDataVector& other) const {
+            OMM_ASSERT(_numStates == other._numStates);
+            uint32_t numDiff = 0;
+            for (size_t i = 0; i < GetWordCount(); ++i)
+            {
+                const uint64_t diff = OmmArrayDataView::To3State(GetWord(i)) ^ OmmArrayDataView::To3State(other.GetWord(i));
+                numDiff += (uint32_t)std::popcount((diff | (diff >> 1ull)) & OmmArrayDataView::kLowBitMask);
+            }
+            return numDiff;
         }
 
     private:
-        vector<uint8_t> data;
-        vector<uint8_t> data3state;
+        OmmArrayDataPool* _pool;
+        uint64_t* _data;
+        ommFormat _format;
+        uint32_t _allocationLevel;
+        uint32_t _numStates;
+        ommOpacityState _uniformState;
     };
 
-    struct OmmWorkItem {
-        uint32_t subdivisionLevel;
-        ommFormat vmFormat;
-        Triangle uvTri;
-        vector<uint32_t> primitiveIndices; // source primitive and identical indices
+    // Work items in structure-of-arrays layout, passes that scan all items only stream the columns they need.
+    // Primitive indices are stored once in CSR form. When a work item is merged in to another its primitive
+    // ranges are linked behind the ranges of the target, so no index is copied after setup.
+    struct OmmWorkItems
+    {
+        static constexpr uint32_t kNoSpecialIndex = 0;
+        static constexpr uint32_t kInvalidIndex = 0xFFFFFFFF;
+
+        OmmWorkItems() = delete;
+        OmmWorkItems(const StdAllocator<uint8_t>& stdAllocator)
+            : subdivisionLevel(stdAllocator)
+            , vmFormat(stdAllocator)
+            , uvTri(stdAllocator)
+            , rotationSource(stdAllocator)
+            , rotation(stdAllocator)
+            , primitiveOffsets(stdAllocator)
+            , primitiveIndices(stdAllocator)
+            , primitiveNext(stdAllocator)
+            , primitiveLast(stdAllocator)
+            , primitiveCount(stdAllocator)
+            , vmDescOffset(stdAllocator)
+            , vmSpecialIndex(stdAllocator)
+            , vmStates(stdAllocator)
+        { }
 
-        OmmWorkItem() = delete;
+        uint32_t Size() const { return (uint32_t)subdivisionLevel.size(); }
 
-        OmmWorkItem(const StdAllocator<uint8_t>& stdAllocator, ommFormat _vmFormat, uint32_t _subdivisionLevel, uint32_t primitiveIndex, const Triangle& _uvTri)
-            : primitiveIndices(stdAllocator)
-            , subdivisionLevel(_subdivisionLevel)
-            , vmFormat(_vmFormat)
-            , uvTri(_uvTri)
-            , vmStates(stdAllocator, _vmFormat, _subdivisionLevel)
+        void Reserve(size_t count)
         {
-            primitiveIndices.push_back(primitiveIndex);
+            subdivisionLevel.reserve(count);
+            vmFormat.reserve(count);
+            uvTri.reserve(count);
+            rotationSource.reserve(count);
+            rotation.reserve(count);
+            vmDescOffset.reserve(count);
+            vmSpecialIndex.reserve(count);
+            vmStates.reserve(count);
         }
 
-        bool HasSpecialIndex() const { return vmSpecialIndex != kNoSpecialIndex; }
+        uint32_t Add(OmmArrayDataPool& statePool, ommFormat format, uint32_t level, const Triangle& tri)
+        {
+            const uint32_t index = Size();
+            subdivisionLevel.push_back(level);
+            vmFormat.push_back(format);
+            uvTri.push_back(tri);
+            rotationSource.push_back(kInvalidIndex);
+            rotation.push_back(0);
+            vmDescOffset.push_back(0xFFFFFFFF);
+            vmSpecialIndex.push_back(kNoSpecialIndex);
+            vmStates.emplace_back(statePool, format, level);
+            return index;
+        }
 
-        static constexpr uint16_t kNoSpecialIndex = 0;
+        // Adds a work item for a triangle whose vertex i is vertex (i + rotation) % 3 of the triangle of item "source".
+        // It is not resampled, ResolveRotatedWorkItems copies the states of the source over in its own vertex order.
+        uint32_t AddRotated(OmmArrayDataPool& statePool, uint32_t source, uint32_t sourceRotation, const Triangle& tri)
+        {
+            const uint32_t index = Add(statePool, vmFormat[source], subdivisionLevel[source], tri);
+            rotationSource[index] = source;
+            rotation[index] = (uint8_t)sourceRotation;
+            return index;
+        }
+
+        bool IsRotated(uint32_t i) const { return rotationSource[i] != kInvalidIndex; }
+
+        // Builds the CSR primitive lists, primitiveToWorkItem holds kInvalidIndex for primitives without work item.
+        void SetupPrimitives(const vector<uint32_t>& primitiveToWorkItem)
+        {
+            const uint32_t numWorkItems = Size();
+            primitiveOffsets.assign(numWorkItems + 1, 0);
+            primitiveNext.assign(numWorkItems, kInvalidIndex);
+            primitiveLast.resize(numWorkItems);
+            primitiveCount.assign(numWorkItems, 0);
+
+            for (uint32_t workItemIdx : primitiveToWorkItem)
+            {
+                if (workItemIdx != kInvalidIndex)
+                    primitiveCount[workItemIdx]++;
+            }
+
+            for (uint32_t i = 0; i < numWorkItems; ++i)
+            {
+                primitiveOffsets[i + 1] = primitiveOffsets[i] + primitiveCount[i];
+                primitiveLast[i] = i;
+            }
+
+            primitiveIndices.resize(primitiveOffsets[numWorkItems]);
+            for (uint32_t primitiveIndex = 0; primitiveIndex < (uint32_t)primitiveToWorkItem.size(); ++primitiveIndex)
+            {
+                const uint32_t workItemIdx = primitiveToWorkItem[primitiveIndex];
+                if (workItemIdx != kInvalidIndex)
+                    primitiveIndices[primitiveOffsets[workItemIdx + 1] - primitiveCount[workItemIdx]--] = primitiveIndex;
+            }
+
+            // The fill above counted down to zero, restore the counts.
+            for (uint32_t i = 0; i < numWorkItems; ++i)
+                primitiveCount[i] = primitiveOffsets[i + 1] - primitiveOffsets[i];
+        }
+
+        bool HasSpecialIndex(uint32_t i) const { return vmSpecialIndex[i] != kNoSpecialIndex; }
+
+        uint32_t GetPrimitiveCount(uint32_t i) const { return primitiveCount[i]; }
+
+        template<class F>
+        void ForEachPrimitive(uint32_t i, F&& fn) const
+        {
+            if (primitiveCount[i] == 0)
+                return;
+            for (uint32_t range = i; range != kInvalidIndex; range = primitiveNext[range])
+            {
+                for (uint32_t it = primitiveOffsets[range]; it < primitiveOffsets[range + 1]; ++it)
+                    fn(primitiveIndices[it]);
+            }
+        }
+
+        // Transfers the primitives of work item "from" to "to" and retires "from". Forever.
+        void MergePrimitives(uint32_t to, uint32_t from)
+        {
+            OMM_ASSERT(to != from);
+            if (primitiveCount[from] != 0)
+            {
+                primitiveNext[primitiveLast[to]] = from;
+                primitiveLast[to] = primitiveLast[from];
+                primitiveCount[to] += primitiveCount[from];
+                primitiveCount[from] = 0;
+            }
+            vmSpecialIndex[from] = -1;
+        }
+
+        // Inputs.
+        vector<uint32_t> subdivisionLevel;
+        vector<ommFormat> vmFormat;
+        vector<Triangle> uvTri;
+        vector<uint32_t> rotationSource;
+        vector<uint8_t> rotation;
+
+        // Source primitive and identical indices.
+        // Work item i owns primitiveIndices[primitiveOffsets[i], primitiveOffsets[i + 1]) followed by the ranges
+        // of the items chained behind it via primitiveNext. primitiveCount is the total over the chain.
+        vector<uint32_t> primitiveOffsets;
+        vector<uint32_t> primitiveIndices;
+        vector<uint32_t> primitiveNext;
+        vector<uint32_t> primitiveLast;
+        vector<uint32_t> primitiveCount;
 
         // Outputs.
-        uint32_t vmDescOffset = 0xFFFFFFFF;
-        uint32_t vmSpecialIndex = kNoSpecialIndex;
-        OmmArrayDataVector vmStates;
+        vector<uint32_t> vmDescOffset;
+        vector<uint32_t> vmSpecialIndex;
+        vector<OmmArrayDataVector> vmStates;
     };
 
     static float GetArea2D(const float2& p0, const float2& p1, const float2& p2) {
@@ -586,9 +1103,64 @@ namespace Cpu
             return FetchUVTriangle(desc.texCoords, texCoordStrideInBytes, desc.texCoordFormat, triangleIndices);
         }
 
+        // Canonical vertices of a uv-triangle for reuse detection. Wrap and mirror addressing sample the same texels after
+        // a translation by whole texture periods, so the triangle is moved to the period holding its bounding box corner.
+        // Wrap addressing of non power of two textures does not repeat for negative texel coordinates and is left as is.
+        // The vertex order is rotated to start at the lexicographically smallest vertex sequence, canonical vertex i is
+        // vertex (i + rotation) % 3 of uvTri.
+        // A non zero quantizationScale snaps the vertices to a grid of 1 / quantizationScale first, the canonical vertices
+        // are then in grid units.
+        static void GetCanonicalTriangle(const Triangle& uvTri, ommTextureAddressMode addressingMode, bool texIsPow2, const float2& quantizationScale,
+            float2 (&canonical)[3], uint32_t& rotation)
+        {
+            const bool quantize = quantizationScale.x != 0.f;
+
+            float2 p[3] = { uvTri.p0, uvTri.p1, uvTri.p2 };
+            if (quantize)
+            {
+                for (float2& v : p)
+                    v = glm::round(v * quantizationScale) / quantizationScale;
+            }
+
+            // Taken from the snapped vertices, so that near identical triangles pick the same period.
+            const float2 aabbS = glm::min(p[0], glm::min(p[1], p[2]));
+
+            float2 offset = float2(0.f);
+            if (addressingMode == ommTextureAddressMode_Wrap && texIsPow2)
+                offset = glm::floor(aabbS);
+            else if (addressingMode == ommTextureAddressMode_Mirror)
+                offset = 2.f * glm::floor(0.5f * aabbS);
+
+            for (float2& v : p)
+                v = quantize ? glm::round((v - offset) * quantizationScale) : v - offset;
+
+            auto IsLess = [&p](uint32_t a, uint32_t b) {
+                for (uint32_t i = 0; i < 3; ++i)
+                {
+                    const float2& pa = p[(a + i) % 3];
+                    const float2& pb = p[(b + i) % 3];
+                    if (pa.x != pb.x)
+                        return pa.x < pb.x;
+                    if (pa.y != pb.y)
+                        return pa.y < pb.y;
+                }
+                return false;
+            };
+
+            rotation = 0;
+            for (uint32_t r = 1; r < 3; ++r)
+            {
+                if (IsLess(r, rotation))
+                    rotation = r;
+            }
+
+            for (uint32_t i = 0; i < 3; ++i)
+                canonical[i] = p[(i + rotation) % 3];
+        }
+
         static ommResult SetupWorkItems(
             const StdAllocator<uint8_t>& allocator, const Logger& log, const ommCpuBakeInputDesc& desc, const Options& options, 
-            vector<OmmWorkItem>& vmWorkItems)
+            OmmArrayDataPool& statePool, OmmWorkItems& vmWorkItems)
         {
             const TextureImpl* texture = GetHandleImpl<TextureImpl>(desc.texture);
 
@@ -596,15 +1168,30 @@ namespace Cpu
 
 
             // 1. Reserve memory.
-            hash_map<size_t, uint32_t> triangleIDToWorkItem(allocator.GetInterface());
-            vmWorkItems.reserve(triangleCount);
+            vector<uint64_t> vmIds(triangleCount, allocator);
+            vector<int32_t> subdivisionLevels(triangleCount, allocator);
+            vector<uint8_t> rotations(triangleCount, allocator);
+            // First primitive with the same vmId, kInvalidIndex for disabled primitives.
+            vector<uint32_t> representative(triangleCount, OmmWorkItems::kInvalidIndex, allocator);
+            vector<uint32_t> primitiveToWorkItem(triangleCount, OmmWorkItems::kInvalidIndex, allocator);
+            vmWorkItems.Reserve(triangleCount);
 
             const int32_t kDisabledPrimitive = 0xE;
 
+            // Vertices are snapped to texCoordQuantization texels of mip 0 for reuse detection.
+            const float2 quantizationScale = desc.texCoordQuantization > 0.f ? (float2)texture->GetSize(0) / desc.texCoordQuantization : float2(0.f);
+
+            auto GetFormat = [&desc](int32_t i) {
+                return !desc.formats || desc.formats[i] == ommFormat_INVALID ? desc.format : desc.formats[i];
+            };
+
             // 2. Reduce uv.
             {
                 uint32_t numDisabledTri = 0;
+                bool exceedsMaxSubdivLevel = false;
 
+                // Fetch, classify and hash every primitive independently.
+                #pragma omp parallel for reduction(+:numDisabledTri) reduction(||:exceedsMaxSubdivLevel) if(options.enableInternalThreads)
                 for (int32_t i = 0; i < triangleCount; ++i)
                 {
                     const Triangle uvTri = GetTriangle(desc, i);
@@ -619,36 +1206,127 @@ namespace Cpu
                         continue; // These indices will be set to special index unknown later.
                     }
 
-                    const ommFormat ommFormat = !desc.formats || desc.formats[i] == ommFormat_INVALID ? desc.format : desc.formats[i];
+                    exceedsMaxSubdivLevel = exceedsMaxSubdivLevel || kMaxSubdivLevel < subdivisionLevel;
 
                     // This is an early check to test for VM reuse.
                     // If subdivision level or format differs we can't reuse the VM.
+                    float2 canonical[3];
+                    uint32_t rotation;
+                    GetCanonicalTriangle(uvTri, desc.runtimeSamplerDesc.addressingMode, texture->SizeIsPow2(), quantizationScale, canonical, rotation);
+
                     std::size_t seed = 42;
-                    hash_combine(seed, uvTri.p0);
-                    hash_combine(seed, uvTri.p1);
-                    hash_combine(seed, uvTri.p2);
+                    hash_combine(seed, canonical[0]);
+                    hash_combine(seed, canonical[1]);
+                    hash_combine(seed, canonical[2]);
                     hash_combine(seed, subdivisionLevel);
-                    hash_combine(seed, ommFormat);
+                    hash_combine(seed, GetFormat(i));
+
+                    vmIds[i] = seed;
+                    subdivisionLevels[i] = subdivisionLevel;
+                    rotations[i] = (uint8_t)rotation;
+                    representative[i] = i;
+                }
+
+                if (exceedsMaxSubdivLevel)
+                {
+                    return log.InvalidArg("[Invalid Argument] - subdivisionLevel for primitive (i) is (d) which exceeds kMaxSubdivLevel(12)");
+                }
+
+                // Find the first primitive of each vmId. Primitives are bucketed into shards on the high bits of the id
+                // in primitive order, each shard then owns a private open addressing table.
+                if (!options.disableDuplicateDetection)
+                {
+                    static constexpr uint32_t kNumShardsLog2 = 6;
+                    static constexpr uint32_t kNumShards = 1u << kNumShardsLog2;
+                    auto GetShard = [](uint64_t vmId) { return (uint32_t)(vmId >> (64 - kNumShardsLog2)); };
 
-                    const uint64_t vmId = seed;
+                    vector<uint32_t> shardOffsets(kNumShards + 1, 0, allocator);
+                    for (int32_t i = 0; i < triangleCount; ++i)
+                    {
+                        if (representative[i] != OmmWorkItems::kInvalidIndex)
+                            shardOffsets[GetShard(vmIds[i]) + 1]++;
+                    }
+                    for (uint32_t shard = 0; shard < kNumShards; ++shard)
+                        shardOffsets[shard + 1] += shardOffsets[shard];
 
-                    auto it = triangleIDToWorkItem.find(vmId);
-                    if ((it == triangleIDToWorkItem.end() || options.disableDuplicateDetection))
+                    vector<uint32_t> shardPrimitives(shardOffsets[kNumShards], allocator);
                     {
-                        if (kMaxSubdivLevel < subdivisionLevel)
+                        vector<uint32_t> shardWrite(shardOffsets.begin(), shardOffsets.end() - 1, allocator);
+                        for (int32_t i = 0; i < triangleCount; ++i)
                         {
-                            return log.InvalidArg("[Invalid Argument] - subdivisionLevel for primitive (i) is (d) which exceeds kMaxSubdivLevel(12)");
+                            if (representative[i] != OmmWorkItems::kInvalidIndex)
+                                shardPrimitives[shardWrite[GetShard(vmIds[i])]++] = i;
                         }
-                        uint32_t workItemIdx = (uint32_t)vmWorkItems.size();
-                        // Temporarily set the triangle->vm desc mapping like this.
-                        triangleIDToWorkItem.insert(std::make_pair(vmId, workItemIdx));
-                        vmWorkItems.emplace_back(allocator, ommFormat, subdivisionLevel, i, uvTri);
                     }
-                    else {
-                        vmWorkItems[it->second].primitiveIndices.push_back(i);
+
+                    #pragma omp parallel for schedule(dynamic, 1) if(options.enableInternalThreads)
+                    for (int32_t shard = 0; shard < (int32_t)kNumShards; ++shard)
+                    {
+                        const uint32_t begin = shardOffsets[shard];
+                        const uint32_t end = shardOffsets[shard + 1];
+                        if (begin == end)
+                            continue;
+
+                        // Power of two with a load factor of at most one half.
+                        uint32_t tableSizeLog2 = 1;
+                        while ((1ull << tableSizeLog2) < 2ull * (end - begin))
+                            tableSizeLog2++;
+                        const uint32_t tableMask = (1u << tableSizeLog2) - 1u;
+                        vector<uint32_t> table(tableMask + 1ull, OmmWorkItems::kInvalidIndex, allocator);
+
+                        for (uint32_t it = begin; it < end; ++it)
+                        {
+                            const uint32_t primitiveIndex = shardPrimitives[it];
+                            const uint64_t vmId = vmIds[primitiveIndex];
+                            // The high bits select the shard, probe on the low bits.
+                            for (uint32_t slot = (uint32_t)vmId & tableMask;; slot = (slot + 1) & tableMask)
+                            {
+                                if (table[slot] == OmmWorkItems::kInvalidIndex)
+                                {
+                                    table[slot] = primitiveIndex;
+                                    break;
+                                }
+                                if (vmIds[table[slot]] == vmId)
+                                {
+                                    representative[primitiveIndex] = table[slot];
+                                    break;
+                                }
+                            }
+                        }
                     }
                 }
 
+                // Work items are created in primitive order, independent of the thread count.
+                // Translated copies share the work item of the first primitive, rotated copies get a work item per
+                // rotation that takes the states of the first one.
+                hash_map<uint64_t, uint32_t> rotatedWorkItems(allocator.GetInterface());
+                for (int32_t i = 0; i < triangleCount; ++i)
+                {
+                    const uint32_t first = representative[i];
+                    if (first == OmmWorkItems::kInvalidIndex)
+                        continue;
+
+                    if (first == (uint32_t)i)
+                    {
+                        primitiveToWorkItem[i] = vmWorkItems.Add(statePool, GetFormat(i), subdivisionLevels[i], GetTriangle(desc, i));
+                    }
+                    else if (rotations[i] == rotations[first])
+                    {
+                        primitiveToWorkItem[i] = primitiveToWorkItem[first];
+                    }
+                    else
+                    {
+                        const uint32_t rotation = (rotations[first] + 3u - rotations[i]) % 3u;
+                        auto it = rotatedWorkItems.find(3ull * first + rotation);
+                        if (it == rotatedWorkItems.end())
+                            it = rotatedWorkItems.insert(std::make_pair(3ull * first + rotation,
+                                vmWorkItems.AddRotated(statePool, primitiveToWorkItem[first], rotation, GetTriangle(desc, i)))).first;
+                        primitiveToWorkItem[i] = it->second;
+                    }
+                }
+
+                vmWorkItems.SetupPrimitives(primitiveToWorkItem);
+
                 if (options.enableValidation && numDisabledTri != 0)
                 {
                     const char* specialIndex = ToString(desc.unresolvedTriState);
@@ -659,7 +1337,14 @@ namespace Cpu
             return ommResult_SUCCESS;
         }
 
-        static uint64_t ComputeWorkloadSize(const ommCpuBakeInputDesc& desc, vector<OmmWorkItem>& vmWorkItems)
+        // Number of texels covered by the bounding box of the uv-triangle.
+        static uint64_t ComputeTexelFootprint(const float2& texSize, const Triangle& uvTri)
+        {
+            const int2 aabb = int2((uvTri.aabb_e - uvTri.aabb_s) * texSize);
+            return uint64_t(aabb.x * aabb.y);
+        }
+
+        static uint64_t ComputeWorkloadSize(const ommCpuBakeInputDesc& desc, const OmmWorkItems& vmWorkItems)
         {
             const TextureImpl* texture = GetHandleImpl<TextureImpl>(desc.texture);
 
@@ -670,17 +1355,17 @@ namespace Cpu
             const float2 sizef = (float2)texture->GetSize(0 /*mip*/);
             uint64_t workloadSize = 0;
 
-            for (const OmmWorkItem& workItem : vmWorkItems)
+            for (uint32_t i = 0; i < vmWorkItems.Size(); ++i)
             {
-                const int2 aabb = int2((workItem.uvTri.aabb_e - workItem.uvTri.aabb_s) * sizef);
-                workloadSize += uint64_t(aabb.x * aabb.y);
+                if (!vmWorkItems.IsRotated(i))
+                    workloadSize += ComputeTexelFootprint(sizef, vmWorkItems.uvTri[i]);
             }
 
             return workloadSize;
         }
 
         static ommResult ValidateWorkloadSize(
-            const StdAllocator<uint8_t>& allocator, Logger log, const ommCpuBakeInputDesc& desc, const Options& options, vector<OmmWorkItem>& ommWorkItems)
+            const StdAllocator<uint8_t>& allocator, Logger log, const ommCpuBakeInputDesc& desc, const Options& options, const OmmWorkItems& ommWorkItems)
         {
             const bool limitWorkloadSize = desc.maxWorkloadSize != 0xFFFFFFFFFFFFFFFF;
 
@@ -712,109 +1397,584 @@ namespace Cpu
             return ommResult_SUCCESS;
         }
 
-        template<ommCpuTextureFormat eFormat, TilingMode eTilingMode, ommTextureAddressMode eTextureAddressMode, ommTextureFilterMode eFilterMode, bool bTexIsPow2>
-        static ommResult ResampleCoarse(const ommCpuBakeInputDesc& desc, const Logger& log, const Options& options, vector<OmmWorkItem>& vmWorkItems)
-        {
-            if (options.enableAABBTesting && !options.disableLevelLineIntersection)
-                return log.InvalidArg("[Invalid Arg] - EnableAABBTesting can't be used without also setting DisableLevelLineIntersection");
+        // Hands out the resample work to the threads most expensive first. With dynamic scheduling the large
+        // triangles start early instead of ending up as the tail of the loop while the other threads idle.
+        // Work items with many micro-triangles are split in to bird-curve index ranges, each a contiguous part of the
+        // triangle, that run as tasks of their own. This way a handful of high level work items still use all threads.
+        // Also measures how much of the pass wall time the worker threads spend on actual work.
+        class ResampleSchedule
+        {
+            using Clock = std::chrono::steady_clock;
+
+            // Setup cost of a single micro-triangle, in texels.
+            static constexpr uint64_t kMicroTriangleCost = 4;
+
+            // Range size of split work items. Multiple of the 32 states per packed word so tasks never share a word.
+            static constexpr uint32_t kMicroTrianglesPerTask = 1u << 14u;
+            static_assert(kMicroTrianglesPerTask % 32u == 0);
+
+            struct alignas(kCacheLineSize) ThreadTime
+            {
+                double busySeconds = 0.0;
+            };
+
+        public:
+            static constexpr uint32_t kNotShared = 0xFFFFFFFF;
+
+            struct Task
+            {
+                uint32_t workItem;
+                uint32_t microTriangleBegin;
+                uint32_t microTriangleEnd;
+                uint32_t sharedIndex; // kNotShared unless the work item is split across several tasks.
+                uint64_t cost;
+            };
+
+            class ScopedTimer
+            {
+            public:
+                ScopedTimer(double& seconds) : _seconds(seconds), _start(Clock::now()) { }
+                ~ScopedTimer() { _seconds += std::chrono::duration<double>(Clock::now() - _start).count(); }
+            private:
+                double& _seconds;
+                Clock::time_point _start;
+            };
+
+            ResampleSchedule(const StdAllocator<uint8_t>& stdAllocator, const Options& options)
+                : _tasks(stdAllocator)
+                , _sharedItems(stdAllocator)
+                , _sharedStates(stdAllocator)
+                , _threadTimes(stdAllocator)
+                , _numThreads(options.enableInternalThreads ? GetMaxThreadCount() : 1)
+                , _wallSeconds(0.0)
+            {
+                _threadTimes.resize(_numThreads);
+            }
+
+            void Setup(const ommCpuBakeInputDesc& desc, const OmmWorkItems& vmWorkItems)
+            {
+                const TextureImpl* texture = GetHandleImpl<TextureImpl>(desc.texture);
+                const float2 sizef = (float2)texture->GetSize(0 /*mip*/);
+
+                const uint32_t numWorkItems = vmWorkItems.Size();
+                _tasks.reserve(numWorkItems);
+                for (uint32_t i = 0; i < numWorkItems; ++i)
+                {
+                    if (vmWorkItems.IsRotated(i))
+                        continue;
+
+                    const uint32_t numMicroTriangles = omm::bird::GetNumMicroTriangles(vmWorkItems.subdivisionLevel[i]);
+                    const uint64_t cost = ComputeTexelFootprint(sizef, vmWorkItems.uvTri[i]) + kMicroTriangleCost * numMicroTriangles;
+
+                    if (_numThreads == 1 || numMicroTriangles <= kMicroTrianglesPerTask)
+                    {
+                        _tasks.push_back({ i, 0, numMicroTriangles, kNotShared, cost });
+                        continue;
+                    }
+
+                    const uint32_t sharedIndex = (uint32_t)_sharedItems.size();
+                    const uint32_t numTasks = math::DivUp(numMicroTriangles, kMicroTrianglesPerTask);
+                    _sharedItems.push_back(i);
+                    for (uint32_t begin = 0; begin < numMicroTriangles; begin += kMicroTrianglesPerTask)
+                    {
+                        const uint32_t end = std::min(begin + kMicroTrianglesPerTask, numMicroTriangles);
+                        _tasks.push_back({ i, begin, end, sharedIndex, cost / numTasks });
+                    }
+                }
+
+                std::sort(_tasks.begin(), _tasks.end(), [](const Task& a, const Task& b) {
+                    if (a.cost != b.cost)
+                        return a.cost > b.cost;
+                    if (a.workItem != b.workItem)
+                        return a.workItem < b.workItem;
+                    return a.microTriangleBegin < b.microTriangleBegin;
+                });
+            }
+
+            // Split work items hand their storage to the tasks for the duration of a pass.
+            void BeginPass(OmmWorkItems& vmWorkItems)
+            {
+                _passStart = Clock::now();
+                _sharedStates.clear();
+                for (uint32_t workItem : _sharedItems)
+                    _sharedStates.push_back(vmWorkItems.vmStates[workItem].Materialize());
+            }
+
+            void EndPass(OmmWorkItems& vmWorkItems)
+            {
+                for (uint32_t workItem : _sharedItems)
+                    vmWorkItems.vmStates[workItem].Compact();
+                _wallSeconds += std::chrono::duration<double>(Clock::now() - _passStart).count();
+            }
+
+            uint32_t Size() const { return (uint32_t)_tasks.size(); }
+            const Task& GetTask(uint32_t scheduleIt) const { return _tasks[scheduleIt]; }
+
+            OmmArrayDataView Stage(const Task& task, const OmmArrayDataVector& vmStates) const {
+                return task.sharedIndex == kNotShared ? vmStates.Stage() : _sharedStates[task.sharedIndex];
+            }
+
+            void Commit(const Task& task, OmmArrayDataVector& vmStates, const OmmArrayDataView& states) const {
+                if (task.sharedIndex == kNotShared)
+                    vmStates.Commit(states);
+            }
+
+            ScopedTimer TimeTask() { return ScopedTimer(_threadTimes[std::min(GetThreadIndex(), _numThreads - 1)].busySeconds); }
+
+            // Accumulated busy time divided by the time the threads were available, -1 if nothing was measured.
+            float GetThreadUtilization() const
+            {
+                if (_wallSeconds <= 0.0)
+                    return -1.f;
+
+                double busySeconds = 0.0;
+                for (const ThreadTime& thread : _threadTimes)
+                    busySeconds += thread.busySeconds;
+
+                return (float)std::min(1.0, busySeconds / (_wallSeconds * _numThreads));
+            }
+
+        private:
+            vector<Task> _tasks;
+            vector<uint32_t> _sharedItems;
+            vector<OmmArrayDataView> _sharedStates;
+            vector<ThreadTime> _threadTimes;
+            const uint32_t _numThreads;
+            double _wallSeconds;
+            Clock::time_point _passStart;
+        };
+
+        // Tries to prove subTri uniform from the min/max alpha pyramid of every mip, without rasterizing it. The texel
+        // footprint of the bounding box is padded by a texel on each side so it holds every texel the conservative raster
+        // may touch, linear filtering adds the second texel of the bilinear footprint. Returns false when a range straddles
+        // the cutoff, mips disagree or a footprint leaves the texture; mixed coverage needs the raster's texel counts.
+        template<ommCpuTextureFormat eFormat, ommTextureFilterMode eFilterMode>
+        static bool ClassifyAlphaRange(const TextureImpl* texture, const Triangle& subTri, float alphaCutoff, OmmCoverage& coverage)
+        {
+            if (!texture->HasAlphaRange())
+                return false;
+
+            const float offset = eFilterMode == ommTextureFilterMode_Linear ? -0.5f : 0.f;
+            const float extent = eFilterMode == ommTextureFilterMode_Linear ? 2.f : 1.f;
+
+            OmmCoverage rangeCoverage = { 0, };
+            for (uint32_t mipIt = 0; mipIt < texture->GetMipCount(); ++mipIt)
+            {
+                const float2 size = texture->GetSizef(mipIt);
+                const float2 s = glm::floor(subTri.aabb_s * size + offset) - 1.f;
+                const float2 e = glm::floor(subTri.aabb_e * size + offset) + extent;
+                if (s.x < 0.f || s.y < 0.f || e.x >= size.x || e.y >= size.y)
+                    return false;
+
+                const float2 range = texture->template GetAlphaRange<eFormat>(int2(s), int2(e), mipIt);
+                if (alphaCutoff < range.x)
+                    rangeCoverage.numAboveAlpha++;
+                else if (!(alphaCutoff < range.y))
+                    rangeCoverage.numBelowAlpha++;
+                else
+                    return false;
+
+                if (rangeCoverage.numAboveAlpha != 0 && rangeCoverage.numBelowAlpha != 0)
+                    return false;
+            }
+
+            coverage = rangeCoverage;
+            return true;
+        }
+
+        // Tries to prove subTri uniform from the cutoff distance of the texel under its centroid. The window of texels a
+        // conservative raster of subTri may touch is bounded by a square around the centroid (a circle in the Chebyshev
+        // metric of the distances), padded like the footprint of ClassifyAlphaRange. When every texel of the window is
+        // closer to the centroid texel than its distance to the other side of the cutoff, they all share its side.
+        // Returns false when a window leaves the texture, is too large or mips disagree.
+        template<ommTextureFilterMode eFilterMode>
+        static bool ClassifyCutoffDistance(const TextureImpl* texture, const Triangle& subTri, OmmCoverage& coverage)
+        {
+            if (!texture->HasCutoffDistance())
+                return false;
+
+            const float offset = eFilterMode == ommTextureFilterMode_Linear ? -0.5f : 0.f;
+            const int32_t extent = eFilterMode == ommTextureFilterMode_Linear ? 2 : 1;
+            const float2 centroid = (subTri.p0 + subTri.p1 + subTri.p2) * (1.f / 3.f);
+
+            OmmCoverage distanceCoverage = { 0, };
+            for (uint32_t mipIt = 0; mipIt < texture->GetMipCount(); ++mipIt)
+            {
+                const float2 size = texture->GetSizef(mipIt);
+                const float2 c = centroid * size;
+                const float2 r = glm::max(glm::max(glm::abs(subTri.p0 * size - c), glm::abs(subTri.p1 * size - c)), glm::abs(subTri.p2 * size - c));
+
+                // floor(r) + 1 rather than ceil(r), so that rounding of c + r can not drop a texel.
+                const float radius = std::max(r.x, r.y);
+                if (!(radius < (float)TextureImpl::kMaxCutoffDistance))
+                    return false;
+                const int32_t window = (int32_t)radius + 1 + extent;
+
+                const int2 texel = int2(glm::floor(c + offset));
+                const int2 sizei = texture->GetSize(mipIt);
+                if (texel.x < window || texel.y < window || texel.x + window >= sizei.x || texel.y + window >= sizei.y)
+                    return false;
+
+                if (texture->GetCutoffDistance(texel, mipIt) <= (uint32_t)window)
+                    return false;
+
+                if (texture->IsAboveAlphaCutoff(texel, mipIt))
+                    distanceCoverage.numAboveAlpha++;
+                else
+                    distanceCoverage.numBelowAlpha++;
+
+                if (distanceCoverage.numAboveAlpha != 0 && distanceCoverage.numBelowAlpha != 0)
+                    return false;
+            }
+
+            coverage = distanceCoverage;
+            return true;
+        }
+
+        // A run of texels along one axis that the address mode maps to the contiguous range [begin, end] of the texture,
+        // or to the border colour.
+        struct TexelSpan
+        {
+            int32_t begin;
+            int32_t end;
+            bool isBorder;
+        };
+
+        static constexpr uint32_t kMaxTexelSpans = 4;
+
+        // Splits the unbounded texel span [s, e] of one axis at texture-period boundaries. Within a period every address
+        // mode maps texels monotonically, or to a single texel once clamped, so each piece is a contiguous range of the
+        // texture. Returns 0 when more than kMaxTexelSpans pieces are needed or a piece does not map contiguously
+        // (wrapping negative coordinates of non power of two textures).
+        template<ommTextureAddressMode eTextureAddressMode, bool bTexIsPow2>
+        static uint32_t SplitTexelSpan(int32_t s, int32_t e, int32_t size, int32_t sizeLog2, TexelSpan (&spans)[kMaxTexelSpans])
+        {
+            auto Map = [size, sizeLog2](int32_t t) {
+                return omm::GetTexCoord<eTextureAddressMode, bTexIsPow2>(int2(t, 0), int2(size, 1), int2(sizeLog2, 0)).x;
+            };
+
+            uint32_t numSpans = 0;
+            for (int32_t t0 = s; t0 <= e;)
+            {
+                if (numSpans == kMaxTexelSpans)
+                    return 0;
+
+                const int32_t period = t0 >= 0 ? t0 / size : -((-t0 - 1) / size) - 1;
+                const int32_t t1 = std::min(e, (period + 1) * size - 1);
+
+                const int32_t m0 = Map(t0);
+                const int32_t m1 = Map(t1);
+                if (m0 == kTexCoordBorder || m1 == kTexCoordBorder)
+                {
+                    OMM_ASSERT(m0 == m1);
+                    spans[numSpans++] = { 0, 0, true };
+                }
+                else
+                {
+                    const bool isContiguous = eTextureAddressMode == ommTextureAddressMode_Wrap ?
+                        m1 - m0 == t1 - t0 :
+                        m0 == m1 || std::abs(m1 - m0) == t1 - t0;
+                    if (!isContiguous)
+                        return 0;
+                    spans[numSpans++] = { std::min(m0, m1), std::max(m0, m1), false };
+                }
+
+                t0 = t1 + 1;
+            }
+            return numSpans;
+        }
+
+        template<ommCpuTextureFormat eFormat, TilingMode eTilingMode, ommTextureAddressMode eTextureAddressMode, ommTextureFilterMode eFilterMode, bool bTexIsPow2>
+        static ommResult ResampleCoarse(const ommCpuBakeInputDesc& desc, const Logger& log, const Options& options, OmmWorkItems& vmWorkItems, ResampleSchedule& schedule)
+        {
+            if (options.enableAABBTesting && !options.disableLevelLineIntersection)
+                return log.InvalidArg("[Invalid Arg] - EnableAABBTesting can't be used without also setting DisableLevelLineIntersection");
+
+            const TextureImpl* texture = GetHandleImpl<TextureImpl>(desc.texture);
+
+            if (!texture->HasSAT())
+                return ommResult_SUCCESS;
+
+            // Footprints are split in integer texel space, coordinates beyond this are left to the raster.
+            const float kMaxTexelCoord = float(1 << 24);
+
+            const bool isBorderAbove = desc.alphaCutoff < desc.runtimeSamplerDesc.borderAlpha;
+
+            // Accumulates the side of the cutoff of the texels in the unbounded texel rectangle [s, e] of a mip. Returns false
+            // when the rectangle doesn't split in to contiguous ranges of the texture.
+            auto ClassifyRect = [&](const int2& s, const int2& e, uint32_t mipIt, bool& hasAbove, bool& hasBelow) -> bool
+            {
+                const int2 size = texture->GetSize(mipIt);
+                const int2 sizeLog2 = texture->GetSizeLog2(mipIt);
+
+                TexelSpan spansX[kMaxTexelSpans];
+                TexelSpan spansY[kMaxTexelSpans];
+                const uint32_t numSpansX = SplitTexelSpan<eTextureAddressMode, bTexIsPow2>(s.x, e.x, size.x, sizeLog2.x, spansX);
+                const uint32_t numSpansY = SplitTexelSpan<eTextureAddressMode, bTexIsPow2>(s.y, e.y, size.y, sizeLog2.y, spansY);
+                if (numSpansX == 0 || numSpansY == 0)
+                    return false;
+
+                for (uint32_t j = 0; j < numSpansY; ++j)
+                {
+                    for (uint32_t i = 0; i < numSpansX; ++i)
+                    {
+                        if (spansX[i].isBorder || spansY[j].isBorder)
+                        {
+                            hasAbove |= isBorderAbove;
+                            hasBelow |= !isBorderAbove;
+                        }
+                        else
+                        {
+                            const int2 spanS = int2(spansX[i].begin, spansY[j].begin);
+                            const int2 spanE = int2(spansX[i].end, spansY[j].end);
+                            const uint32_t area = uint32_t(spanE.x - spanS.x + 1) * uint32_t(spanE.y - spanS.y + 1);
+                            const uint32_t numAbove = texture->SAT(spanS, spanE, mipIt);
+                            hasAbove |= numAbove != 0;
+                            hasBelow |= numAbove != area;
+                        }
+
+                        if (hasAbove && hasBelow)
+                            return true;
+                    }
+                }
+                return true;
+            };
+
+            // The x extent of the part of the texel space triangle p within the strip [y, y + 1], padded for rounding and
+            // clipped to the bounding box [aabbS, aabbE].
+            auto GetStripExtent = [](const float2 (&p)[3], const float2& aabbS, const float2& aabbE, float y) -> float2
+            {
+                float lo = std::numeric_limits<float>::max();
+                float hi = std::numeric_limits<float>::lowest();
+                for (uint32_t i = 0; i < 3; ++i)
+                {
+                    const float2& a = p[i];
+                    const float2& b = p[(i + 1) % 3];
+                    if (a.y >= y && a.y <= y + 1.f)
+                    {
+                        lo = std::min(lo, a.x);
+                        hi = std::max(hi, a.x);
+                    }
+
+                    if (a.y == b.y)
+                        continue;
+
+                    for (const float edgeY : { y, y + 1.f })
+                    {
+                        if (edgeY < std::min(a.y, b.y) || edgeY > std::max(a.y, b.y))
+                            continue;
+                        const float x = a.x + (edgeY - a.y) * (b.x - a.x) / (b.y - a.y);
+                        lo = std::min(lo, x);
+                        hi = std::max(hi, x);
+                    }
+                }
+
+                if (lo > hi)
+                    return float2(aabbS.x, aabbE.x);
+
+                const float pad = 1e-3f + 1e-6f * std::max(std::abs(lo), std::abs(hi));
+                return float2(std::max(lo - pad, aabbS.x), std::min(hi + pad, aabbE.x));
+            };
+
+            // Accumulates the texels read when sampling anywhere in the texel space triangle p, one row span at a time.
+            // Samples in the strips [stripBegin, stripEnd] are read.
+            auto ClassifyRows = [&](const float2 (&p)[3], const float2& aabbS, const float2& aabbE, int32_t stripBegin, int32_t stripEnd,
+                uint32_t mipIt, bool& hasAbove, bool& hasBelow) -> bool
+            {
+                // Linear filtering reads row r from the samples in strips r - 1 and r, and left of zero from r - 2 as well.
+                const int32_t rowEnd = eFilterMode == ommTextureFilterMode_Linear ? stripEnd + (stripBegin < 0 ? 2 : 1) : stripEnd;
+                for (int32_t row = stripBegin; row <= rowEnd; ++row)
+                {
+                    float lo = std::numeric_limits<float>::max();
+                    float hi = std::numeric_limits<float>::lowest();
+                    auto AddStrip = [&](int32_t strip) {
+                        if (strip < stripBegin || strip > stripEnd)
+                            return;
+                        const float2 extent = GetStripExtent(p, aabbS, aabbE, (float)strip);
+                        lo = std::min(lo, extent.x);
+                        hi = std::max(hi, extent.y);
+                    };
+
+                    AddStrip(row);
+                    if (eFilterMode == ommTextureFilterMode_Linear)
+                    {
+                        AddStrip(row - 1);
+                        if (row - 2 < 0)
+                            AddStrip(row - 2);
+                    }
+
+                    if (lo > hi)
+                        continue;
+
+                    const int32_t s = (int32_t)std::floor(lo);
+                    int32_t e = (int32_t)std::floor(hi);
+                    if (eFilterMode == ommTextureFilterMode_Linear)
+                        e += s < 0 ? 2 : 1;
+
+                    if (!ClassifyRect(int2(s, row), int2(e, row), mipIt, hasAbove, hasBelow))
+                        return false;
+                    if (hasAbove && hasBelow)
+                        return true;
+                }
+                return true;
+            };
+
+            // Classifies the texels read when sampling anywhere in subTri, in every mip. Leaves the state alone unless all of
+            // them are on the same side of the cutoff. The bounding box is tested first, only when it is mixed are the
+            // texels counted row span by row span.
+            auto Classify = [&](const Triangle& subTri, ommOpacityState& state) -> bool
+            {
+                bool hasAbove = false;
+                bool hasBelow = false;
+                for (uint32_t mipIt = 0; mipIt < texture->GetMipCount(); ++mipIt)
+                {
+                    const float2 sizef = texture->GetSizef(mipIt);
+
+                    // Linear filtering reads the texel pair around every sample, nearest the texel under it. The bilinear
+                    // kernels round texel coordinates toward zero, left of zero they read one texel further.
+                    const float offset = eFilterMode == ommTextureFilterMode_Linear ? -0.5f : 0.f;
+                    const float2 aabbS = subTri.aabb_s * sizef + offset;
+                    const float2 aabbE = subTri.aabb_e * sizef + offset;
+                    const float2 fs = glm::floor(aabbS);
+                    const float2 fe = glm::floor(aabbE);
+                    if (glm::any(glm::greaterThan(glm::abs(fs), float2(kMaxTexelCoord))) || glm::any(glm::greaterThan(glm::abs(fe), float2(kMaxTexelCoord))))
+                        return false;
+
+                    const int2 s = int2(fs);
+                    int2 e = int2(fe);
+                    if (eFilterMode == ommTextureFilterMode_Linear)
+                    {
+                        e.x += s.x < 0 ? 2 : 1;
+                        e.y += s.y < 0 ? 2 : 1;
+                    }
 
-            const TextureImpl* texture = GetHandleImpl<TextureImpl>(desc.texture);
+                    bool mipAbove = false;
+                    bool mipBelow = false;
+                    if (!ClassifyRect(s, e, mipIt, mipAbove, mipBelow))
+                        return false;
 
-            if (!texture->HasSAT())
-                return ommResult_SUCCESS;
+                    if (mipAbove && mipBelow)
+                    {
+                        mipAbove = false;
+                        mipBelow = false;
+                        const float2 p[3] = { subTri.p0 * sizef + offset, subTri.p1 * sizef + offset, subTri.p2 * sizef + offset };
+                        if (!ClassifyRows(p, aabbS, aabbE, s.y, (int32_t)fe.y, mipIt, mipAbove, mipBelow))
+                            return false;
+                    }
 
-            if (texture->GetMipCount() != 1)
-                return ommResult_SUCCESS;
+                    hasAbove |= mipAbove;
+                    hasBelow |= mipBelow;
+                    if (hasAbove && hasBelow)
+                        return false;
+                }
+
+                OMM_ASSERT(hasAbove != hasBelow);
+                state = hasAbove ? desc.alphaCutoffGreater : desc.alphaCutoffLessEqual;
+                return true;
+            };
 
             // 3. Process the queue of unique triangles...
             {
-                const int32_t numWorkItems = (int32_t)vmWorkItems.size();
+                const int32_t numTasks = (int32_t)schedule.Size();
+                schedule.BeginPass(vmWorkItems);
 
                 // 3.1 Rasterize...
                 {
-                    #pragma omp parallel for if(options.enableInternalThreads)
-                    for (int32_t workItemIt = 0; workItemIt < numWorkItems; ++workItemIt) {
+                    #pragma omp parallel for schedule(dynamic, 1) if(options.enableInternalThreads)
+                    for (int32_t scheduleIt = 0; scheduleIt < numTasks; ++scheduleIt) {
+                        const ResampleSchedule::Task& task = schedule.GetTask(scheduleIt);
+                        const uint32_t workItemIt = task.workItem;
+                        ResampleSchedule::ScopedTimer taskTimer = schedule.TimeTask();
 
-                        // 3.2 figure out the sub-states via rasterization...
+                        // 3.2 figure out the sub-states from the summed area tables...
                         {
                             // Subdivide the input triangle in to smaller triangles. They will be "bird-curve" ordered.
-                            OmmWorkItem& workItem = vmWorkItems[workItemIt];
+                            const Triangle& uvTri = vmWorkItems.uvTri[workItemIt];
+                            const uint32_t subdivisionLevel = vmWorkItems.subdivisionLevel[workItemIt];
+                            OmmArrayDataVector& vmStates = vmWorkItems.vmStates[workItemIt];
 
-                            const uint32_t numMicroTriangles = omm::bird::GetNumMicroTriangles(workItem.subdivisionLevel);
+                            OmmArrayDataView states = schedule.Stage(task, vmStates);
 
-                            // Perform rasterization of each individual VM.
-                            if (eFilterMode == ommTextureFilterMode_Linear)
+                            omm::bird::MicroTriangleIterator microTri(uvTri, task.microTriangleBegin, subdivisionLevel);
+                            for (uint32_t uTriIt = task.microTriangleBegin; uTriIt < task.microTriangleEnd; ++uTriIt, microTri.Next())
                             {
-                                // Run conservative rasterization on the micro triangle
-                                for (uint32_t uTriIt = 0; uTriIt < numMicroTriangles; ++uTriIt)
-                                {
-                                    const Triangle subTri = omm::bird::GetMicroTriangle(workItem.uvTri, uTriIt, workItem.subdivisionLevel);
-
-                                    const int32_t Sx = (int32_t)subTri.aabb_s.x;
-                                    const int32_t Sy = (int32_t)subTri.aabb_s.y;
+                                ommOpacityState state;
+                                if (Classify(microTri.GetTriangle(), state))
+                                    states.SetState(uTriIt, state);
+                            }
 
-                                    const int32_t Ex = (int32_t)subTri.aabb_e.x;
-                                    const int32_t Ey = (int32_t)subTri.aabb_e.y;
+                            schedule.Commit(task, vmStates, states);
+                        }
+                    }
+                }
 
-                                    if (Sx != Ex || Sy != Ey)
-                                    {
-                                        continue;
-                                    }
+                schedule.EndPass(vmWorkItems);
+            }
+            return ommResult_SUCCESS;
+        }
 
-                                    const uint32_t mip = 0;
+        enum TriangleClass
+        {
+            Normal,
+            Degenerate
+        };
 
-                                    const float2 faabb_s = (subTri.aabb_s * (float2)texture->GetSize(mip)) - 0.5f;
-                                    const float2 faabb_e = (subTri.aabb_e * (float2)texture->GetSize(mip)) - 0.5f;
-                                    int2 iaabb_s[TexelOffset::MAX_NUM];
-                                    omm::GatherTexCoord4<eTextureAddressMode, bTexIsPow2>(glm::floor(faabb_s), texture->GetSize(mip), texture->GetSizeLog2(mip), iaabb_s);
+        // Walks the bird curve hierarchy above the micro-triangles in [begin, end) top down. The range must be a whole
+        // subtree, i.e. 4^k micro-triangles starting at a multiple of 4^k. An ancestor that classify proves to be
+        // entirely above or below the cutoff resolves all of its micro-triangles at once, only descendants of mixed
+        // ancestors are visited. Micro-triangles of mixed parents are left for the per micro-triangle pass.
+        template<class TClassify>
+        static void ClassifyAncestors(const ommCpuBakeInputDesc& desc, const Triangle& uvTri, uint32_t subdivisionLevel,
+            uint32_t begin, uint32_t end, OmmArrayDataView& states, TClassify&& classify)
+        {
+            const uint32_t count = end - begin;
+            OMM_ASSERT(count != 0 && (count & (count - 1)) == 0 && (begin & (count - 1)) == 0);
 
-                                    int2 iaabb_e[TexelOffset::MAX_NUM];
-                                    omm::GatherTexCoord4<eTextureAddressMode, bTexIsPow2>(glm::floor(faabb_e), texture->GetSize(mip), texture->GetSizeLog2(mip), iaabb_e);
+            uint32_t subtreeDepth = 0;
+            while ((1u << (subtreeDepth << 1u)) < count)
+                ++subtreeDepth;
+            OMM_ASSERT((1u << (subtreeDepth << 1u)) == count && subtreeDepth <= subdivisionLevel);
 
-                                    const int2 aabb_s = iaabb_s[TexelOffset::I0x0];
-                                    const int2 aabb_e = iaabb_e[TexelOffset::I1x1];
+            if (subtreeDepth == 0)
+                return;
 
-                                    // This means the micro-triangle wraps over the image border.
-                                    if (aabb_e.x < aabb_s.x || aabb_e.y < aabb_s.y)
-                                        continue;
+            struct Node
+            {
+                uint32_t level;
+                uint32_t index;
+            };
 
-                                    if (!texture->InTexture(aabb_s, mip) || !texture->InTexture(aabb_e, mip))
-                                    {
-                                        continue;
-                                    }
+            // Depth first, every level adds at most three pending siblings.
+            Node stack[3 * kMaxNumSubdivLevels + 1];
+            uint32_t stackSize = 0;
+            stack[stackSize++] = { subdivisionLevel - subtreeDepth, begin >> (subtreeDepth << 1u) };
 
-                                    const int2 aabb = (aabb_e - aabb_s);
-                                    const uint32_t area = (aabb.x + 1) * (aabb.y + 1);
+            while (stackSize != 0)
+            {
+                const Node node = stack[--stackSize];
 
-                                    const uint32_t sa = texture->SAT(aabb_s, aabb_e, mip);
+                const Triangle subTri = omm::bird::GetMicroTriangle(uvTri, node.index, node.level);
+                const OmmCoverage coverage = classify(subTri, true /*stopOnMixedCoverage*/);
 
-                                    if (sa == 0)
-                                    {
-                                        // (Less than or equal to alpha threshold)
-                                        workItem.vmStates.SetState(uTriIt, desc.alphaCutoffLessEqual);
-                                    }
-                                    else if (sa == area)
-                                    {
-                                        // (Greater than alpha threshold)
-                                        workItem.vmStates.SetState(uTriIt, desc.alphaCutoffGreater);
-                                    }
-                                }
-                            }
-                        }
-                    }
+                if (coverage.numAboveAlpha == 0 || coverage.numBelowAlpha == 0)
+                {
+                    const ommOpacityState state = GetStateFromCoverage(desc.format, desc.unknownStatePromotion, desc.alphaCutoffGreater, desc.alphaCutoffLessEqual, coverage);
+                    const uint32_t shift = (subdivisionLevel - node.level) << 1u;
+                    states.FillRange(node.index << shift, (node.index + 1) << shift, state);
+                    continue;
                 }
+
+                if (node.level + 1 == subdivisionLevel)
+                    continue;
+
+                // Push in reverse so children are visited in bird curve order.
+                for (uint32_t child = 4; child-- > 0;)
+                    stack[stackSize++] = { node.level + 1, (node.index << 2u) + child };
             }
-            return ommResult_SUCCESS;
         }
 
-        enum TriangleClass
-        {
-            Normal,
-            Degenerate
-        };
-
         template<ommCpuTextureFormat eFormat, TilingMode eTilingMode, ommTextureAddressMode eTextureAddressMode, ommTextureFilterMode eFilterMode, TriangleClass eTriangleClass, bool bTexIsPow2>
-        static ommResult ResampleFine(const ommCpuBakeInputDesc& desc, const Logger& log, const Options& options, vector<OmmWorkItem>& vmWorkItems)
+        static ommResult ResampleFine(const ommCpuBakeInputDesc& desc, const Logger& log, const Options& options, OmmWorkItems& vmWorkItems, ResampleSchedule& schedule)
         {
             if (options.enableAABBTesting && !options.disableLevelLineIntersection)
                 return log.InvalidArg("[Invalid Arg] - EnableAABBTesting can't be used without also setting DisableLevelLineIntersection");
@@ -826,19 +1986,25 @@ namespace Cpu
 
             // 3. Process the queue of unique triangles...
             {
-                const int32_t numWorkItems = (int32_t)vmWorkItems.size();
+                const int32_t numTasks = (int32_t)schedule.Size();
+                schedule.BeginPass(vmWorkItems);
 
                 // 3.1 Rasterize...
                 {
-                    #pragma omp parallel for if(options.enableInternalThreads)
-                    for (int32_t workItemIt = 0; workItemIt < numWorkItems; ++workItemIt) {
+                    #pragma omp parallel for schedule(dynamic, 1) if(options.enableInternalThreads)
+                    for (int32_t scheduleIt = 0; scheduleIt < numTasks; ++scheduleIt) {
+                        const ResampleSchedule::Task& task = schedule.GetTask(scheduleIt);
+                        const uint32_t workItemIt = task.workItem;
+                        ResampleSchedule::ScopedTimer taskTimer = schedule.TimeTask();
                         auto kernel = &LevelLineIntersectionKernel::run<eFormat, eTextureAddressMode, eTilingMode, eTriangleClass, bTexIsPow2>;
 
                         // 3.2 figure out the sub-states via rasterization...
                         {
                             // Subdivide the input triangle in to smaller triangles. They will be "bird-curve" ordered.
-                            OmmWorkItem& workItem = vmWorkItems[workItemIt];
-                            const bool isDegenerate = workItem.uvTri.GetIsDegenerate();
+                            const Triangle& uvTri = vmWorkItems.uvTri[workItemIt];
+                            const uint32_t subdivisionLevel = vmWorkItems.subdivisionLevel[workItemIt];
+                            OmmArrayDataVector& vmStates = vmWorkItems.vmStates[workItemIt];
+                            const bool isDegenerate = uvTri.GetIsDegenerate();
 
                             if (eTriangleClass == TriangleClass::Normal && isDegenerate)
                             {
@@ -850,20 +2016,98 @@ namespace Cpu
                                 continue;
                             }
 
-                            const uint32_t numMicroTriangles = omm::bird::GetNumMicroTriangles(workItem.subdivisionLevel);
+                            OmmArrayDataView states = schedule.Stage(task, vmStates);
+
+                            // The exact coverage counts are only needed to promote unknown states to the nearest known state.
+                            const bool stopOnMixedCoverage = desc.unknownStatePromotion != ommUnknownStatePromotion_Nearest;
+
+                            // Classifies texels by the range of their four interpolants. Used to prove the coverage of whole subtrees,
+                            // bilinear interpolation never leaves that range so any micro-triangle inside ends up with the same state.
+                            auto ClassifyBilinearBounds = [&desc, texture](const Triangle& subTri, bool stopOnMixedCoverage) -> OmmCoverage
+                            {
+                                OmmCoverage vmCoverage = { 0, };
+                                if (ClassifyCutoffDistance<ommTextureFilterMode_Linear>(texture, subTri, vmCoverage) ||
+                                    ClassifyAlphaRange<eFormat, ommTextureFilterMode_Linear>(texture, subTri, desc.alphaCutoff, vmCoverage))
+                                    return vmCoverage;
+
+                                for (uint32_t mipIt = 0; mipIt < texture->GetMipCount(); ++mipIt)
+                                {
+                                    const int2 rasterSize = texture->GetSize(mipIt);
+                                    const float2 pixelOffset = -float2(0.5, 0.5);
+
+                                    BilinearBoundsKernel::Params params = { &vmCoverage,  texture->GetRcpSize(mipIt), rasterSize, texture->GetSizeLog2(mipIt), texture, desc.alphaCutoff, desc.runtimeSamplerDesc.borderAlpha, mipIt, stopOnMixedCoverage };
+                                    BilinearBoundsKernel::Functor<eFormat, eTextureAddressMode, eTilingMode, bTexIsPow2> kernel = { params };
+                                    RasterizeConservativeSerialWithOffsetTiled(subTri, rasterSize, pixelOffset, kernel, &BilinearBoundsKernel::runTile, &params);
+
+                                    if (vmCoverage.numAboveAlpha != 0 && vmCoverage.numBelowAlpha != 0)
+                                        break;
+                                }
+                                return vmCoverage;
+                            };
+
+                            auto ClassifyNearest = [&desc, texture](const Triangle& subTri, bool stopOnMixedCoverage) -> OmmCoverage
+                            {
+                                OmmCoverage vmCoverage = { 0, };
+                                if (ClassifyCutoffDistance<ommTextureFilterMode_Nearest>(texture, subTri, vmCoverage) ||
+                                    ClassifyAlphaRange<eFormat, ommTextureFilterMode_Nearest>(texture, subTri, desc.alphaCutoff, vmCoverage))
+                                    return vmCoverage;
+
+                                // With the embedded cutoff whole tiles are counted from the opacity bits, otherwise every texel is loaded.
+                                const bool useSAT = texture->HasSAT();
+                                for (uint32_t mipIt = 0; mipIt < texture->GetMipCount(); ++mipIt)
+                                {
+                                    const int2 rasterSize = texture->GetSize(mipIt);
+                                    NearestKernel::Params params = { &vmCoverage, rasterSize, texture->GetSizeLog2(mipIt), texture, desc.alphaCutoff, desc.runtimeSamplerDesc.borderAlpha, mipIt, stopOnMixedCoverage };
+
+                                    if (useSAT)
+                                    {
+                                        auto kernel = &NearestKernel::run<eFormat, eTextureAddressMode, eTilingMode, bTexIsPow2, true>;
+                                        RasterizeConservativeSerialWithOffsetTiled(subTri, rasterSize, float2(0, 0), kernel, &NearestKernel::runTile, &params);
+                                    }
+                                    else
+                                    {
+                                        auto kernel = &NearestKernel::run<eFormat, eTextureAddressMode, eTilingMode, bTexIsPow2, false>;
+                                        RasterizeConservativeSerial(subTri, rasterSize, kernel, &params);
+                                    }
+                                    OMM_ASSERT(vmCoverage.numAboveAlpha != 0 || vmCoverage.numBelowAlpha != 0);
+
+                                    const ommOpacityState state = GetStateFromCoverage(desc.format, desc.unknownStatePromotion, desc.alphaCutoffGreater, desc.alphaCutoffLessEqual, vmCoverage);
+                                    if (IsUnknown(state))
+                                        break;
+                                }
+                                return vmCoverage;
+                            };
+
+                            // Ancestors with known coverage resolve all their micro-triangles at once.
+                            if constexpr (eTriangleClass == TriangleClass::Normal)
+                            {
+                                if (eFilterMode == ommTextureFilterMode_Linear && !options.disableLevelLineIntersection)
+                                    ClassifyAncestors(desc, uvTri, subdivisionLevel, task.microTriangleBegin, task.microTriangleEnd, states, ClassifyBilinearBounds);
+                                else if (eFilterMode == ommTextureFilterMode_Nearest)
+                                    ClassifyAncestors(desc, uvTri, subdivisionLevel, task.microTriangleBegin, task.microTriangleEnd, states, ClassifyNearest);
+                            }
 
                             // Perform rasterization of each individual VM.
                             if (eFilterMode == ommTextureFilterMode_Linear)
                             {
                                 // Run conservative rasterization on the micro triangle
-                                for (uint32_t uTriIt = 0; uTriIt < numMicroTriangles; ++uTriIt)
+                                omm::bird::MicroTriangleIterator microTri(uvTri, task.microTriangleBegin, subdivisionLevel);
+                                for (uint32_t uTriIt = task.microTriangleBegin; uTriIt < task.microTriangleEnd; ++uTriIt, microTri.Next())
                                 {
-                                    if (workItem.vmStates.GetState(uTriIt) != ommOpacityState_UnknownOpaque)
+                                    if (states.GetState(uTriIt) != ommOpacityState_UnknownOpaque)
                                     {
                                         continue;
                                     }
 
-                                    const Triangle subTri = omm::bird::GetMicroTriangle(workItem.uvTri, uTriIt, workItem.subdivisionLevel);
+                                    const Triangle subTri = microTri.GetTriangle();
+
+                                    OmmCoverage rangeCoverage = { 0, };
+                                    if (ClassifyCutoffDistance<ommTextureFilterMode_Linear>(texture, subTri, rangeCoverage) ||
+                                        ClassifyAlphaRange<eFormat, ommTextureFilterMode_Linear>(texture, subTri, desc.alphaCutoff, rangeCoverage))
+                                    {
+                                        states.SetState(uTriIt, GetStateFromCoverage(desc.format, desc.unknownStatePromotion, desc.alphaCutoffGreater, desc.alphaCutoffLessEqual, rangeCoverage));
+                                        continue;
+                                    }
 
                                     // Figure out base-state by sampling at the center of the triangle.
                                     if (!options.disableLevelLineIntersection) 
@@ -877,7 +2121,7 @@ namespace Cpu
                                             const int2 rasterSize = texture->GetSize(mipIt);
 
 
-                                            LevelLineIntersectionKernel::Params params = { &vmCoverage,  &subTri, texture->GetRcpSize(mipIt), rasterSize, texture, desc.alphaCutoff, desc.runtimeSamplerDesc.borderAlpha, mipIt };
+                                            LevelLineIntersectionKernel::Params params = { &vmCoverage,  &subTri, texture->GetRcpSize(mipIt), rasterSize, texture, desc.alphaCutoff, desc.runtimeSamplerDesc.borderAlpha, mipIt, stopOnMixedCoverage };
 
                                             // This offset (in pixel units) will be applied to the triangle,
                                             // the effect is that the raster grid is being mapped such that bilinear interpolation region defined by
@@ -893,14 +2137,14 @@ namespace Cpu
 
                                             if constexpr (eTriangleClass == TriangleClass::Normal)
                                             {
-                                                auto kernel = &LevelLineIntersectionKernel::run<eFormat, eTextureAddressMode, eTilingMode, false /*degenerate*/, bTexIsPow2>;
-                                                RasterizeConservativeSerialWithOffsetCoverage(subTri, rasterSize, pixelOffset, kernel, &params);
+                                                LevelLineIntersectionKernel::Functor<eFormat, eTextureAddressMode, eTilingMode, false /*degenerate*/, bTexIsPow2> kernel = { params };
+                                                RasterizeConservativeSerialWithOffsetCoverage(subTri, rasterSize, pixelOffset, kernel, nullptr);
                                             }
                                             else
                                             {
-                                                auto kernel = &LevelLineIntersectionKernel::run<eFormat, eTextureAddressMode, eTilingMode, true /*degenerate*/, bTexIsPow2>;
+                                                LevelLineIntersectionKernel::Functor<eFormat, eTextureAddressMode, eTilingMode, true /*degenerate*/, bTexIsPow2> kernel = { params };
                                                 Line l(subTri.aabb_s, subTri.aabb_e);
-                                                RasterizeConservativeLineWithOffset(l, rasterSize, pixelOffset, kernel, &params);
+                                                RasterizeConservativeLineWithOffset(l, rasterSize, pixelOffset, kernel, nullptr);
                                             }
 
                                             OMM_ASSERT(vmCoverage.numAboveAlpha != 0 || vmCoverage.numBelowAlpha != 0);
@@ -910,7 +2154,7 @@ namespace Cpu
                                                 break;
                                         }
                                         const ommOpacityState state = GetStateFromCoverage(desc.format, desc.unknownStatePromotion, desc.alphaCutoffGreater, desc.alphaCutoffLessEqual, vmCoverage);
-                                        workItem.vmStates.SetState(uTriIt, state);
+                                        states.SetState(uTriIt, state);
                                     }
                                     else if (options.enableAABBTesting)
                                     {
@@ -925,18 +2169,18 @@ namespace Cpu
                                         float2 pixelOffset = -float2(0.5, 0.5);
 
                                         OmmCoverage vmCoverage = { 0, };
-                                        ConservativeBilinearKernel::Params params = { &vmCoverage,  texture->GetRcpSize(mip), rasterSize, texture->GetSizeLog2(mip), texture, desc.alphaCutoff, desc.runtimeSamplerDesc.borderAlpha, mip };
+                                        ConservativeBilinearKernel::Params params = { &vmCoverage,  texture->GetRcpSize(mip), rasterSize, texture->GetSizeLog2(mip), texture, desc.alphaCutoff, desc.runtimeSamplerDesc.borderAlpha, mip, stopOnMixedCoverage };
 
                                         Triangle subTri0 = Triangle(subTri.aabb_s, float2(subTri.aabb_e.x, subTri.aabb_s.y), float2(subTri.aabb_s.x, subTri.aabb_e.y));
                                         Triangle subTri1 = Triangle(subTri.aabb_e, float2(subTri.aabb_e.x, subTri.aabb_s.y), float2(subTri.aabb_s.x, subTri.aabb_e.y));
-                                        auto kernel = &ConservativeBilinearKernel::run<eFormat, eTextureAddressMode, eTilingMode, bTexIsPow2>;
-                                        RasterizeConservativeSerialWithOffsetCoverage(subTri0, rasterSize, pixelOffset, kernel, &params);
-                                        RasterizeConservativeSerialWithOffsetCoverage(subTri1, rasterSize, pixelOffset, kernel, &params);
+                                        ConservativeBilinearKernel::Functor<eFormat, eTextureAddressMode, eTilingMode, bTexIsPow2> kernel = { params };
+                                        RasterizeConservativeSerialWithOffsetCoverage(subTri0, rasterSize, pixelOffset, kernel, nullptr);
+                                        RasterizeConservativeSerialWithOffsetCoverage(subTri1, rasterSize, pixelOffset, kernel, nullptr);
 
                                         OMM_ASSERT(vmCoverage.numAboveAlpha != 0 || vmCoverage.numBelowAlpha != 0);
 
                                         const ommOpacityState state = GetStateFromCoverage(desc.format, desc.unknownStatePromotion, desc.alphaCutoffGreater, desc.alphaCutoffLessEqual, vmCoverage);
-                                        workItem.vmStates.SetState(uTriIt, state);
+                                        states.SetState(uTriIt, state);
                                     }
                                     else
                                     {
@@ -953,173 +2197,184 @@ namespace Cpu
                                         float2 pixelOffset = -float2(0.5, 0.5);
 
                                         OmmCoverage vmCoverage = { 0, };
-                                        ConservativeBilinearKernel::Params params = { &vmCoverage,  texture->GetRcpSize(mip), rasterSize, rasterSizeLog2, texture, desc.alphaCutoff, desc.runtimeSamplerDesc.borderAlpha, mip };
+                                        ConservativeBilinearKernel::Params params = { &vmCoverage,  texture->GetRcpSize(mip), rasterSize, rasterSizeLog2, texture, desc.alphaCutoff, desc.runtimeSamplerDesc.borderAlpha, mip, stopOnMixedCoverage };
 
-                                        auto kernel = &ConservativeBilinearKernel::run<eFormat, eTextureAddressMode, eTilingMode, bTexIsPow2>;
-                                        RasterizeConservativeSerialWithOffsetCoverage(subTri, rasterSize, pixelOffset, kernel, &params);
+                                        ConservativeBilinearKernel::Functor<eFormat, eTextureAddressMode, eTilingMode, bTexIsPow2> kernel = { params };
+                                        RasterizeConservativeSerialWithOffsetCoverage(subTri, rasterSize, pixelOffset, kernel, nullptr);
 
                                         OMM_ASSERT(vmCoverage.numBelowAlpha != 0 || vmCoverage.numAboveAlpha != 0);
 
                                         const ommOpacityState state = GetStateFromCoverage(desc.format, desc.unknownStatePromotion, desc.alphaCutoffGreater, desc.alphaCutoffLessEqual, vmCoverage);
 
-                                        workItem.vmStates.SetState(uTriIt, state);
+                                        states.SetState(uTriIt, state);
                                     }
                                 }
                             }
                             else if (eFilterMode == ommTextureFilterMode_Nearest)
                             {
-                                struct KernelParams {
-                                    OmmCoverage*        vmState;
-                                    float2              invSize;
-                                    int2                size;
-                                    int2                sizeLog2;
-                                    ommSamplerDesc      runtimeSamplerDesc;
-                                    const TextureImpl* texture;
-                                    float               alphaCutoff;
-                                    float               borderAlpha;
-                                    uint32_t            mipIt;
-                                };
-
-                                for (uint32_t uTriIt = 0; uTriIt < numMicroTriangles; ++uTriIt)
+                                omm::bird::MicroTriangleIterator microTri(uvTri, task.microTriangleBegin, subdivisionLevel);
+                                for (uint32_t uTriIt = task.microTriangleBegin; uTriIt < task.microTriangleEnd; ++uTriIt, microTri.Next())
                                 {
-                                    OmmCoverage vmCoverage = { 0, };
-                                    for (uint32_t mipIt = 0; mipIt < texture->GetMipCount(); ++mipIt)
+                                    if (states.GetState(uTriIt) != ommOpacityState_UnknownOpaque)
                                     {
-                                        const int2 rasterSize = texture->GetSize(mipIt);
-                                        const int2 rasterSizeLog2 = texture->GetSizeLog2(mipIt);
-                                        KernelParams params = { nullptr, texture->GetRcpSize(mipIt), rasterSize, rasterSizeLog2,desc.runtimeSamplerDesc, texture, desc.alphaCutoff, desc.runtimeSamplerDesc.borderAlpha, mipIt };
-
-                                        params.vmState = &vmCoverage;
-
-                                        auto kernel = [](int2 pixel, void* ctx)
-                                        {
-                                            KernelParams* p = (KernelParams*)ctx;
-
-                                            const int2 coord = omm::GetTexCoord<eTextureAddressMode, bTexIsPow2>(pixel, p->size, p->sizeLog2);
-
-                                            const bool isBorder = eTextureAddressMode == ommTextureAddressMode_Border && (coord.x == kTexCoordBorder || coord.y == kTexCoordBorder);
-                                            const float alpha = isBorder ? p->borderAlpha : p->texture->template Load<eFormat, eTilingMode>(coord, p->mipIt);
-
-                                            if (p->alphaCutoff < alpha) {
-                                                p->vmState->numAboveAlpha++;
-                                            }
-                                            else {
-                                                p->vmState->numBelowAlpha++;
-                                            }
-                                        };
-
-                                        const Triangle subTri = omm::bird::GetMicroTriangle(workItem.uvTri, uTriIt, workItem.subdivisionLevel);
-
-                                        RasterizeConservativeSerial(subTri, rasterSize, kernel, &params);
-                                        OMM_ASSERT(vmCoverage.numAboveAlpha != 0 || vmCoverage.numBelowAlpha != 0);
-
-                                        const ommOpacityState state = GetStateFromCoverage(desc.format, desc.unknownStatePromotion, desc.alphaCutoffGreater, desc.alphaCutoffLessEqual, vmCoverage);
-                                        if (IsUnknown(state))
-                                            break;
+                                        continue;
                                     }
+
+                                    const Triangle subTri = microTri.GetTriangle();
+                                    const OmmCoverage vmCoverage = ClassifyNearest(subTri, stopOnMixedCoverage);
                                     const ommOpacityState state = GetStateFromCoverage(desc.format, desc.unknownStatePromotion, desc.alphaCutoffGreater, desc.alphaCutoffLessEqual, vmCoverage);
-                                    workItem.vmStates.SetState(uTriIt, state);
+                                    states.SetState(uTriIt, state);
                                 }
                             }
+
+                            schedule.Commit(task, vmStates, states);
                         }
                     }
                 }
+
+                schedule.EndPass(vmWorkItems);
+            }
+            return ommResult_SUCCESS;
+        }
+
+        // Fills the rotated work items from their source. Rotating the vertex order only permutes the discrete
+        // barycentrics (w, u, v) of a micro-triangle, its index in the source follows from the permuted coordinates.
+        static ommResult ResolveRotatedWorkItems(const Options& options, OmmWorkItems& vmWorkItems)
+        {
+            #pragma omp parallel for schedule(dynamic, 1) if(options.enableInternalThreads)
+            for (int32_t i = 0; i < (int32_t)vmWorkItems.Size(); ++i)
+            {
+                if (!vmWorkItems.IsRotated(i))
+                    continue;
+
+                const OmmArrayDataVector& sourceStates = vmWorkItems.vmStates[vmWorkItems.rotationSource[i]];
+                const uint32_t rotation = vmWorkItems.rotation[i];
+                const uint32_t subdivisionLevel = vmWorkItems.subdivisionLevel[i];
+                const uint32_t coordMask = (1u << subdivisionLevel) - 1u;
+
+                OmmArrayDataView states = vmWorkItems.vmStates[i].Stage();
+                for (uint32_t uTriIt = 0; uTriIt < states.GetNumStates(); ++uTriIt)
+                {
+                    uint32_t dbary[3];
+                    omm::bird::index2dbary(uTriIt, dbary[1], dbary[2], dbary[0]);
+
+                    // Vertex k of this triangle is vertex k + rotation of the source.
+                    const uint32_t w = dbary[(3u - rotation) % 3u] & coordMask;
+                    const uint32_t u = dbary[(4u - rotation) % 3u] & coordMask;
+                    const uint32_t v = dbary[(5u - rotation) % 3u] & coordMask;
+                    states.SetState(uTriIt, sourceStates.GetState(omm::bird::dbary2index(u, v, w, subdivisionLevel)));
+                }
+                vmWorkItems.vmStates[i].Commit(states);
             }
             return ommResult_SUCCESS;
         }
 
-        static ommResult DeduplicateExact(const StdAllocator<uint8_t>& allocator, const Options& options, vector<OmmWorkItem>& vmWorkItems)
+        static ommResult DeduplicateExact(const StdAllocator<uint8_t>& allocator, const Options& options, OmmWorkItems& vmWorkItems)
         {
             if (options.disableDuplicateDetection)
                 return ommResult_SUCCESS;
 
-            uint32_t dupesFound = 0;
+            const int32_t numWorkItems = (int32_t)vmWorkItems.Size();
 
-            auto CalcDigest = [&allocator](const OmmWorkItem& workItem) {
-                return XXH64((const void*)workItem.vmStates.GetOmm3StateData(), workItem.vmStates.GetOmm3StateDataSize(), 42/*seed*/);
-            };
+            // 1. Digest the states of all items still in use. Items retired by an earlier merge have no primitives
+            // left to transfer or receive.
+            vector<XXH128_hash_t> digests(numWorkItems, allocator);
+            #pragma omp parallel for schedule(dynamic, 1) if(options.enableInternalThreads)
+            for (int32_t i = 0; i < numWorkItems; ++i)
+            {
+                if (vmWorkItems.GetPrimitiveCount(i) != 0)
+                    digests[i] = vmWorkItems.vmStates[i].Compute3StateDigest(42/*seed*/);
+            }
 
-            hash_map<uint64_t, uint32_t> digestToWorkItemIndex(allocator.GetInterface());
-            for (uint32_t i = 0; i < vmWorkItems.size(); ++i)
+            // 2. The first item of each digest becomes the merge target, in item order. Items whose digests only share
+            // low64 are chained behind the first of them so each digest keeps its own target.
+            vector<uint32_t> mergeTarget(numWorkItems, OmmWorkItems::kInvalidIndex, allocator);
             {
-                const OmmWorkItem& workItem = vmWorkItems[i];
-                uint64_t digest = CalcDigest(workItem);
-                auto it = digestToWorkItemIndex.find(digest);
-                if (it == digestToWorkItemIndex.end())
+                hash_map<uint64_t, uint32_t> digestToWorkItemIndex(allocator.GetInterface());
+                vector<uint32_t> nextWithLow64(numWorkItems, OmmWorkItems::kInvalidIndex, allocator);
+                for (int32_t i = 0; i < numWorkItems; ++i)
                 {
-                    digestToWorkItemIndex.insert(std::make_pair(digest, i));
-                }
-                else
-                {
-                    // Transfer primitives to the new VM index...
-                    OmmWorkItem& existingWorkItem = vmWorkItems[it->second];
-                    existingWorkItem.primitiveIndices.insert(existingWorkItem.primitiveIndices.end(), workItem.primitiveIndices.begin(), workItem.primitiveIndices.end());
-
-                    // Get rid if this work item. Forver.
-                    vmWorkItems[i].primitiveIndices.clear();
-                    vmWorkItems[i].vmSpecialIndex = -1;
-                    dupesFound++;
+                    if (vmWorkItems.GetPrimitiveCount(i) == 0)
+                        continue;
+
+                    auto it = digestToWorkItemIndex.find(digests[i].low64);
+                    if (it == digestToWorkItemIndex.end())
+                    {
+                        digestToWorkItemIndex.insert(std::make_pair(digests[i].low64, i));
+                        continue;
+                    }
+
+                    uint32_t target = it->second;
+                    while (!XXH128_isEqual(digests[target], digests[i]) && nextWithLow64[target] != OmmWorkItems::kInvalidIndex)
+                        target = nextWithLow64[target];
+
+                    if (XXH128_isEqual(digests[target], digests[i]))
+                        mergeTarget[i] = target;
+                    else
+                        nextWithLow64[target] = i;
                 }
             }
 
+            // 3. Compare the states, a digest collision only costs the reuse.
+            #pragma omp parallel for schedule(dynamic, 1) if(options.enableInternalThreads)
+            for (int32_t i = 0; i < numWorkItems; ++i)
+            {
+                const uint32_t to = mergeTarget[i];
+                if (to != OmmWorkItems::kInvalidIndex && !vmWorkItems.vmStates[to].Is3StateEqual(vmWorkItems.vmStates[i]))
+                    mergeTarget[i] = OmmWorkItems::kInvalidIndex;
+            }
+
+            for (int32_t i = 0; i < numWorkItems; ++i)
+            {
+                // Transfer primitives to the new VM index...
+                if (mergeTarget[i] != OmmWorkItems::kInvalidIndex)
+                    vmWorkItems.MergePrimitives(mergeTarget[i] /*to*/, i /*from*/);
+            }
+
             return ommResult_SUCCESS;
         }
 
-        static float HammingDistance3State(const OmmWorkItem& workItemA, const OmmWorkItem& workItemB)
+        static float HammingDistance3State(const OmmWorkItems& vmWorkItems, uint32_t workItemA, uint32_t workItemB)
         {
-            OMM_ASSERT(workItemA.subdivisionLevel == workItemB.subdivisionLevel);
-            const uint32_t numMicroTriangles = omm::bird::GetNumMicroTriangles(workItemA.subdivisionLevel);
-            uint32_t numDiff = 0;
-            for (uint32_t uTriIt = 0; uTriIt < numMicroTriangles; ++uTriIt) {
-
-                ommOpacityState stateA = workItemA.vmStates.Get3State(uTriIt);
-                ommOpacityState stateB = workItemB.vmStates.Get3State(uTriIt);
-
-                if (stateA != stateB)
-                    numDiff++;
-            }
-
-            return float(numDiff);
+            OMM_ASSERT(vmWorkItems.subdivisionLevel[workItemA] == vmWorkItems.subdivisionLevel[workItemB]);
+            return float(vmWorkItems.vmStates[workItemA].HammingDistance3State(vmWorkItems.vmStates[workItemB]));
         };
 
         // Computes hamming distnace, returns false if sizes don't match.
-        static float NormalizedHammingDistance3State(const OmmWorkItem& workItemA, const OmmWorkItem& workItemB)
+        static float NormalizedHammingDistance3State(const OmmWorkItems& vmWorkItems, uint32_t workItemA, uint32_t workItemB)
         {
-            OMM_ASSERT(workItemA.subdivisionLevel == workItemB.subdivisionLevel);
-            const uint32_t numMicroTriangles = omm::bird::GetNumMicroTriangles(workItemA.subdivisionLevel);
-            return HammingDistance3State(workItemA, workItemB) / numMicroTriangles;
+            OMM_ASSERT(vmWorkItems.subdivisionLevel[workItemA] == vmWorkItems.subdivisionLevel[workItemB]);
+            const uint32_t numMicroTriangles = omm::bird::GetNumMicroTriangles(vmWorkItems.subdivisionLevel[workItemA]);
+            return HammingDistance3State(vmWorkItems, workItemA, workItemB) / numMicroTriangles;
         };
 
-        static ommResult MergeWorkItems(OmmWorkItem& to, OmmWorkItem& from)
+        static ommResult MergeWorkItems(OmmWorkItems& vmWorkItems, uint32_t to, uint32_t from)
         {
-            OMM_ASSERT(to.subdivisionLevel == from.subdivisionLevel);
+            OMM_ASSERT(vmWorkItems.subdivisionLevel[to] == vmWorkItems.subdivisionLevel[from]);
 
             // Transfer primitives to the new VM index...
-            to.primitiveIndices.insert(to.primitiveIndices.end(), from.primitiveIndices.begin(), from.primitiveIndices.end());
-
-            // Get rid if this work item. Forver.
-            from.primitiveIndices.clear();
-            from.vmSpecialIndex = -1;
+            vmWorkItems.MergePrimitives(to, from);
 
             // Merge states from A -> B.
-            uint32_t numMatches = 0;
-            const uint32_t numMicroTriangles = omm::bird::GetNumMicroTriangles(from.subdivisionLevel);
+            OmmArrayDataVector& toStates = vmWorkItems.vmStates[to];
+            const OmmArrayDataVector& fromStates = vmWorkItems.vmStates[from];
+            const uint32_t numMicroTriangles = omm::bird::GetNumMicroTriangles(vmWorkItems.subdivisionLevel[from]);
 
             for (uint32_t uTriIt = 0; uTriIt < numMicroTriangles; ++uTriIt) {
 
-                ommOpacityState toState = to.vmStates.GetState(uTriIt);
-                ommOpacityState fromState = from.vmStates.GetState(uTriIt);
+                ommOpacityState toState = toStates.GetState(uTriIt);
+                ommOpacityState fromState = fromStates.GetState(uTriIt);
 
                 if (toState != fromState)
                 {
                     if (IsKnown(fromState) && IsKnown(toState))
                     {
-                        to.vmStates.SetState(uTriIt, ommOpacityState_UnknownOpaque);
+                        toStates.SetState(uTriIt, ommOpacityState_UnknownOpaque);
                     }
                     else if (IsKnown(toState) && IsUnknown(fromState))
                     {
                         // Use the unknown state A as our new unknown.
-                        to.vmStates.SetState(uTriIt, fromState);
+                        toStates.SetState(uTriIt, fromState);
                     }
                     else // if (IsUnknown(toState) && IsUnknown(fromState))
                     {
@@ -1131,7 +2386,7 @@ namespace Cpu
             return ommResult_SUCCESS;
         }
 
-        static ommResult DeduplicateSimilarLSH(const StdAllocator<uint8_t>& allocator, const ommCpuBakeInputDesc& desc, const Options& options, vector<OmmWorkItem>& vmWorkItems, uint32_t iterations)
+        static ommResult DeduplicateSimilarLSH(const StdAllocator<uint8_t>& allocator, const ommCpuBakeInputDesc& desc, const Options& options, OmmWorkItems& vmWorkItems, uint32_t iterations)
         {
             if (options.disableDuplicateDetection)
                 return ommResult_SUCCESS;
@@ -1144,44 +2399,91 @@ namespace Cpu
 
             std::mt19937 mt(42);
 
-            uint32_t match = 0;
-            uint32_t trueMatch = 0;
-            uint32_t falseMatch = 0;
-            uint32_t noMatch = 0;
+            // Candidates of one work item in insertion order, backed by a small open addressing table.
+            struct CandidateSet
+            {
+                vector<uint32_t> slots;
+                vector<uint32_t> items;
+                CandidateSet(const StdAllocator<uint8_t>& allocator) :slots(allocator), items(allocator)
+                { }
+
+                void Reset(uint32_t maxSize) {
+                    slots.assign(nextPow2(std::max(4 * maxSize, 16u)), OmmWorkItems::kInvalidIndex);
+                    items.clear();
+                }
 
-            for (uint32_t attempts = 0; attempts < iterations; ++attempts)
+                void Insert(uint32_t item) {
+                    const uint32_t mask = (uint32_t)slots.size() - 1;
+                    for (uint32_t slot = (item * 0x9E3779B1u) & mask;; slot = (slot + 1) & mask)
+                    {
+                        if (slots[slot] == item)
+                            return;
+                        if (slots[slot] == OmmWorkItems::kInvalidIndex)
+                        {
+                            slots[slot] = item;
+                            items.push_back(item);
+                            return;
+                        }
+                    }
+                }
+
+                void Clear() {
+                    for (uint32_t item : items)
+                    {
+                        const uint32_t mask = (uint32_t)slots.size() - 1;
+                        uint32_t slot = (item * 0x9E3779B1u) & mask;
+                        while (slots[slot] != item)
+                            slot = (slot + 1) & mask;
+                        slots[slot] = OmmWorkItems::kInvalidIndex;
+                    }
+                    items.clear();
+                }
+            };
+
+            struct HashTable
             {
-                vector<uint32_t> batchWorkItems(allocator);
-                batchWorkItems.reserve(vmWorkItems.size());
+                vector<uint32_t> bitIndices; // random bit indices
+                vector<uint64_t> workItemHashes;
+                vector<std::pair<uint64_t, uint32_t>> buckets; // (hash, work item) sorted, a bucket lists its work items in order.
+                HashTable(const StdAllocator<uint8_t>& allocator) :bitIndices(allocator), workItemHashes(allocator), buckets(allocator)
+                { }
+            };
 
-                struct HashTable
-                {
-                    vector<uint32_t> bitIndices; // random bit indices
-                    vector<uint64_t> workItemHashes;
-                    hash_map<uint64_t, vector<uint32_t>> layerHashToWorkItem;
-                    HashTable(const StdAllocator<uint8_t>& allocator) :bitIndices(allocator), workItemHashes(allocator), layerHashToWorkItem(allocator)
-                    { }
-                };
+            const uint32_t numThreads = options.enableInternalThreads ? GetMaxThreadCount() : 1;
 
-                vector<HashTable> hashTables(allocator);
-                vector<uint32_t> bitSamples(allocator);
-                set<uint32_t> potentialMatches(allocator);
+            vector<uint32_t> batchWorkItems(allocator);
+            batchWorkItems.reserve(vmWorkItems.Size());
+            vector<HashTable> hashTables(allocator);
+            vector<uint32_t> bitSamples(allocator);
+            vector<CandidateSet> candidateSets(numThreads, CandidateSet(allocator), allocator);
+            vector<uint32_t> nearestWorkItem(allocator);
+            // Candidates found by the parallel search, appended per thread and located by a span per batch item.
+            struct CandidateSpan
+            {
+                uint32_t threadIndex;
+                uint32_t count;
+                size_t offset;
+            };
+            vector<vector<uint32_t>> threadCandidates(numThreads, vector<uint32_t>(allocator), allocator);
+            vector<CandidateSpan> candidateSpans(allocator);
+            // Work items merged from or in to during the current level.
+            vector<uint8_t> modified(vmWorkItems.Size(), 0, allocator);
 
+            for (uint32_t attempts = 0; attempts < iterations; ++attempts)
+            {
                 for (uint32_t subdivisionLevel = 1; subdivisionLevel <= kMaxSubdivLevel; ++subdivisionLevel)
                 {
                     batchWorkItems.clear();
 
-                    for (uint32_t i = 0; i < vmWorkItems.size(); ++i)
+                    for (uint32_t i = 0; i < vmWorkItems.Size(); ++i)
                     {
-                        OmmWorkItem& workItem = vmWorkItems[i];
-
-                        if (workItem.vmSpecialIndex != OmmWorkItem::kNoSpecialIndex)
+                        if (vmWorkItems.HasSpecialIndex(i))
                             continue;
 
-                        if (workItem.vmFormat != ommFormat_OC1_4_State)
+                        if (vmWorkItems.vmFormat[i] != ommFormat_OC1_4_State)
                             continue;
 
-                        if (workItem.subdivisionLevel != subdivisionLevel)
+                        if (vmWorkItems.subdivisionLevel[i] != subdivisionLevel)
                             continue;
 
                         batchWorkItems.push_back(i);
@@ -1203,9 +2505,6 @@ namespace Cpu
                     const float r = desc.nearDuplicateDeduplicationFactor /* 0.15f*/ * d;   // Distance must be at most 25%
                     const float c = 4.0f;        // Allow 2x deviation from this
 
-                    const float p1 = 1 - r / d;         // Lower bound probability, for close two points
-                    const float p2 = 1 - (c * r) / d;   // Upper bound probability, for far two points
-
                     const float p = 1.f / c;
                     const float Lf = glm::ceil(std::pow((float)n, p));
                     const uint32_t L = (uint32_t)Lf;
@@ -1217,18 +2516,12 @@ namespace Cpu
                     if (k == 0)
                         continue;
 
-                    const uint32_t bigO = L * (d + k);  // O(L(d+k)), for instance c = 2 => O(sqrt(n)*(d + k))
-                    const uint32_t bigO2 = n * n;       // O(N^2)
-
-                    const float ratio = (float)bigO / bigO2;
-
                     hashTables.resize(L, allocator);
 
                     for (HashTable& hashTable : hashTables)
                     {
-                        hashTable.workItemHashes.resize(vmWorkItems.size(), 0);
+                        hashTable.workItemHashes.resize(vmWorkItems.Size(), 0);
                         hashTable.bitIndices.resize(k);
-                        hashTable.layerHashToWorkItem.clear();
                         for (uint32_t& bitIndex : hashTable.bitIndices)
                         {
                             // We're not using std::uniform_int_distribution, the output is not defined in spec and may differ between compilers
@@ -1237,121 +2530,145 @@ namespace Cpu
                         }
                     }
 
-                    bitSamples.resize(k);
-                    for (uint32_t workItemIndex : batchWorkItems)
+                    bitSamples.resize(size_t(numThreads) * k);
+                    #pragma omp parallel for if(options.enableInternalThreads)
+                    for (int32_t batchIt = 0; batchIt < (int32_t)n; ++batchIt)
                     {
-                        const OmmWorkItem& workItem = vmWorkItems[workItemIndex];
+                        const uint32_t workItemIndex = batchWorkItems[batchIt];
+                        const OmmArrayDataVector& vmStates = vmWorkItems.vmStates[workItemIndex];
+                        uint32_t* samples = bitSamples.data() + size_t(std::min(GetThreadIndex(), numThreads - 1)) * k;
 
                         for (HashTable& hashTable : hashTables)
                         {
                             for (uint32_t kIt = 0; kIt < k; ++kIt)
                             {
                                 const uint32_t randomBitIndex = hashTable.bitIndices[kIt];
-                                ommOpacityState state = workItem.vmStates.Get3State(randomBitIndex);
-                                bitSamples[kIt] = (uint32_t)state;
+                                ommOpacityState state = vmStates.Get3State(randomBitIndex);
+                                samples[kIt] = (uint32_t)state;
                             }
 
-                            uint64_t hash = XXH64((const void*)bitSamples.data(), sizeof(uint32_t) * bitSamples.size(), 42/*seed*/);
-
-                            hashTable.workItemHashes[workItemIndex] = hash;
-
-                            auto it = hashTable.layerHashToWorkItem.find(hash);
-                            if (it != hashTable.layerHashToWorkItem.end())
-                            {
-                                it->second.push_back(workItemIndex);
-                            }
-                            else
-                            {
-                                vector<uint32_t> layerHashToWorkItem(allocator);
-                                layerHashToWorkItem.push_back(workItemIndex);
-                                hashTable.layerHashToWorkItem.insert(std::make_pair(hash, layerHashToWorkItem));
-                            }
+                            hashTable.workItemHashes[workItemIndex] = XXH64((const void*)samples, sizeof(uint32_t) * k, 42/*seed*/);
                         }
                     }
 
-                    // Now we can do the merging.
-                    for (uint32_t workItemIndex : batchWorkItems)
+                    #pragma omp parallel for schedule(dynamic, 1) if(options.enableInternalThreads)
+                    for (int32_t tableIt = 0; tableIt < (int32_t)L; ++tableIt)
                     {
-                        OmmWorkItem& workItem = vmWorkItems[workItemIndex];
-
-                        if (workItem.HasSpecialIndex()) // This might happen if we have already merged this work item.
-                            continue;
+                        HashTable& hashTable = hashTables[tableIt];
+                        hashTable.buckets.resize(n);
+                        for (uint32_t batchIt = 0; batchIt < n; ++batchIt)
+                        {
+                            const uint32_t workItemIndex = batchWorkItems[batchIt];
+                            hashTable.buckets[batchIt] = std::make_pair(hashTable.workItemHashes[workItemIndex], workItemIndex);
+                        }
+                        std::sort(hashTable.buckets.begin(), hashTable.buckets.end());
+                    }
 
-                        potentialMatches.clear();
+                    // Collects the candidates sharing a bucket with workItemIndex, capped once more than 3L are found.
+                    auto GatherCandidates = [&](uint32_t workItemIndex, CandidateSet& potentialMatches) {
+                        potentialMatches.Clear();
                         for (const HashTable& hashTable : hashTables)
                         {
                             uint64_t hash = hashTable.workItemHashes[workItemIndex];
 
                             OMM_ASSERT(hash != 0);
 
-                            auto it = hashTable.layerHashToWorkItem.find(hash);
+                            auto it = std::lower_bound(hashTable.buckets.begin(), hashTable.buckets.end(), std::make_pair(hash, 0u));
 
-                            OMM_ASSERT(it != hashTable.layerHashToWorkItem.end());
+                            OMM_ASSERT(it != hashTable.buckets.end() && it->first == hash);
 
-                            for (uint32_t potentialWorkItemIndex : it->second)
+                            for (; it != hashTable.buckets.end() && it->first == hash; ++it)
                             {
+                                const uint32_t potentialWorkItemIndex = it->second;
                                 if (potentialWorkItemIndex == workItemIndex)
                                     continue;
 
-                                const OmmWorkItem& potentialWorkItem = vmWorkItems[potentialWorkItemIndex];
-
-                                if (potentialWorkItem.HasSpecialIndex())
+                                if (vmWorkItems.HasSpecialIndex(potentialWorkItemIndex))
                                     continue;
-                                
-                                if (potentialMatches.size() > 3 * L)
+
+                                if (potentialMatches.items.size() > 3 * L)
                                     break;
 
-                                potentialMatches.insert(potentialWorkItemIndex);
+                                potentialMatches.Insert(potentialWorkItemIndex);
                             }
                         }
+                    };
 
-                        // out of potential matches... pick best one.
+                    // Out of potential matches... pick best one, ties go to the lowest index.
+                    auto FindNearest = [&](uint32_t workItemIndex, const CandidateSet& potentialMatches)->uint32_t {
                         float minDist = std::numeric_limits<float>::max();
-                        int32_t nearestIndex = -1;
-                        for (uint32_t potentialMatch : potentialMatches)
+                        uint32_t nearestIndex = OmmWorkItems::kInvalidIndex;
+                        for (uint32_t potentialMatch : potentialMatches.items)
                         {
-                            const OmmWorkItem& maybeSimilarWorkItem = vmWorkItems[potentialMatch];
-
-                            const float dist = HammingDistance3State(workItem, maybeSimilarWorkItem);
-                            if (dist < r && dist < minDist)
+                            const float dist = HammingDistance3State(vmWorkItems, workItemIndex, potentialMatch);
+                            if (dist < r && (dist < minDist || (dist == minDist && potentialMatch < nearestIndex)))
                             {
                                 minDist = dist;
                                 nearestIndex = potentialMatch;
                             }
                         }
+                        return nearestIndex;
+                    };
 
-                        if (nearestIndex >= 0)
-                        {
-                            OmmWorkItem& similarWorkItem = vmWorkItems[nearestIndex];
+                    for (CandidateSet& candidateSet : candidateSets)
+                        candidateSet.Reset(3 * L + 2);
 
-                            trueMatch++;
-                            MergeWorkItems(workItem /*to*/, similarWorkItem /*from*/);
-                            OMM_ASSERT(similarWorkItem.HasSpecialIndex());
-                        }
-                        else
+                    for (vector<uint32_t>& candidates : threadCandidates)
+                        candidates.clear();
+
+                    // Search all work items against the states before merging, keeping the candidates of each.
+                    nearestWorkItem.resize(n);
+                    candidateSpans.resize(n);
+                    #pragma omp parallel for schedule(dynamic, 1) if(options.enableInternalThreads)
+                    for (int32_t batchIt = 0; batchIt < (int32_t)n; ++batchIt)
+                    {
+                        const uint32_t threadIndex = std::min(GetThreadIndex(), numThreads - 1);
+                        CandidateSet& potentialMatches = candidateSets[threadIndex];
+                        GatherCandidates(batchWorkItems[batchIt], potentialMatches);
+                        nearestWorkItem[batchIt] = FindNearest(batchWorkItems[batchIt], potentialMatches);
+
+                        vector<uint32_t>& candidates = threadCandidates[threadIndex];
+                        candidateSpans[batchIt] = { threadIndex, (uint32_t)potentialMatches.items.size(), candidates.size() };
+                        candidates.insert(candidates.end(), potentialMatches.items.begin(), potentialMatches.items.end());
+                    }
+
+                    // Now we can do the merging, in order. A search is only repeated if one of its candidates was merged
+                    // from or in to, the buckets can't yield other candidates otherwise: items that were skipped already
+                    // had a special index and are never merged again.
+                    for (uint32_t batchIt = 0; batchIt < n; ++batchIt)
+                    {
+                        const uint32_t workItemIndex = batchWorkItems[batchIt];
+                        if (vmWorkItems.HasSpecialIndex(workItemIndex)) // This might happen if we have already merged this work item.
+                            continue;
+
+                        const CandidateSpan& span = candidateSpans[batchIt];
+                        const uint32_t* candidates = threadCandidates[span.threadIndex].data() + span.offset;
+
+                        uint32_t nearestIndex = nearestWorkItem[batchIt];
+                        if (std::any_of(candidates, candidates + span.count, [&modified](uint32_t c) { return modified[c] != 0; }))
                         {
-                            falseMatch++;
+                            GatherCandidates(workItemIndex, candidateSets[0]);
+                            nearestIndex = FindNearest(workItemIndex, candidateSets[0]);
                         }
 
-                        if (potentialMatches.size() == 1)
-                            match++;
-                        else
-                            noMatch++;
-
-                        uint32_t dummy = (uint32_t)potentialMatches.size();
-                        const uint32_t dummy2 = dummy;
+                        if (nearestIndex != OmmWorkItems::kInvalidIndex)
+                        {
+                            MergeWorkItems(vmWorkItems, workItemIndex /*to*/, nearestIndex /*from*/);
+                            OMM_ASSERT(vmWorkItems.HasSpecialIndex(nearestIndex));
+                            modified[workItemIndex] = 1;
+                            modified[nearestIndex] = 1;
+                        }
                     }
+
+                    for (uint32_t workItemIndex : batchWorkItems)
+                        modified[workItemIndex] = 0;
                 }
             }
-            
-           // const float ratio = float(match) / noMatch;
-            volatile const float ratio = float(noMatch) / trueMatch;
-            volatile const float ratio2 = float(noMatch) / trueMatch;
 
             return ommResult_SUCCESS;
         }
 
-        static ommResult DeduplicateSimilarBruteForce(const StdAllocator<uint8_t>& allocator, const Options& options, vector<OmmWorkItem>& vmWorkItems)
+        static ommResult DeduplicateSimilarBruteForce(const StdAllocator<uint8_t>& allocator, const Options& options, OmmWorkItems& vmWorkItems)
         {
             if (options.disableDuplicateDetection)
                 return ommResult_SUCCESS;
@@ -1359,7 +2676,7 @@ namespace Cpu
             if (!options.enableNearDuplicateDetection || !options.enableNearDuplicateDetectionBruteForce)
                return ommResult_SUCCESS;
 
-            if (vmWorkItems.size() == 0)
+            if (vmWorkItems.Size() == 0)
                 return ommResult_SUCCESS;
 
             // The purpose of this pass is to identify "similar" OMMs, and then merge those.
@@ -1371,88 +2688,90 @@ namespace Cpu
             static constexpr float kMergeThreshold = 0.1f; // If two OMMs differ less than kMergeThreshold % (treating all unknowns as equal) -> then we combine them.
             static constexpr uint32_t kMaxComparsions = 2048; // Covert the O(n^2) nature of the algorithm to a -> O(kN) version...
 
-            set<uint32_t> mergedWorkItems(allocator);
-            for (uint32_t itA = 0; itA < vmWorkItems.size() - 1; ++itA)
-            {
-                OmmWorkItem& workItemA = vmWorkItems[itA];
-
-                if (workItemA.vmSpecialIndex != OmmWorkItem::kNoSpecialIndex)
-                    continue;
-
-                if (workItemA.vmFormat != ommFormat_OC1_4_State)
-                    continue;
-
+            auto FindNearest = [&vmWorkItems](uint32_t itA)->uint32_t {
                 const uint32_t searchOffsetBase = itA + 1;
                 const uint32_t searchStart = searchOffsetBase;
-                const uint32_t searchEnd = std::min<uint32_t>(kMaxComparsions + searchStart, (uint32_t)vmWorkItems.size());
+                const uint32_t searchEnd = std::min<uint32_t>(kMaxComparsions + searchStart, vmWorkItems.Size());
 
                 float minDist = std::numeric_limits<float>::max();
-                int32_t nearestIndex = -1;
+                uint32_t nearestIndex = OmmWorkItems::kInvalidIndex;
                 for (uint32_t itB = searchStart; itB < searchEnd; ++itB)
                 {
-                    const OmmWorkItem& workItemB = vmWorkItems[itB];
-
-                    if (workItemB.vmSpecialIndex != OmmWorkItem::kNoSpecialIndex)
-                        continue;
-
-                    if (workItemB.vmFormat != ommFormat_OC1_4_State)
+                    if (vmWorkItems.HasSpecialIndex(itB))
                         continue;
 
-                    if (workItemB.primitiveIndices.empty())
+                    if (vmWorkItems.vmFormat[itB] != ommFormat_OC1_4_State)
                         continue;
 
-                    if (workItemA.subdivisionLevel != workItemB.subdivisionLevel)
+                    if (vmWorkItems.GetPrimitiveCount(itB) == 0)
                         continue;
 
-                    if (mergedWorkItems.find(itB) != mergedWorkItems.end())
+                    if (vmWorkItems.subdivisionLevel[itA] != vmWorkItems.subdivisionLevel[itB])
                         continue;
 
-                    const float dist = NormalizedHammingDistance3State(workItemA, workItemB);
+                    const float dist = NormalizedHammingDistance3State(vmWorkItems, itA, itB);
 
                     if (dist < kMergeThreshold && dist < minDist)
                     {
                         minDist = dist;
-                        nearestIndex = (int32_t)itB;
+                        nearestIndex = itB;
                     }
                 }
+                return nearestIndex;
+            };
 
-                if (nearestIndex >= 0)
-                {
-                    OmmWorkItem& workItemB = vmWorkItems[nearestIndex];
+            auto IsCandidate = [&vmWorkItems](uint32_t it) {
+                return !vmWorkItems.HasSpecialIndex(it) && vmWorkItems.vmFormat[it] == ommFormat_OC1_4_State;
+            };
 
-                    mergedWorkItems.insert(itA);
-                    mergedWorkItems.insert(nearestIndex);
-                    MergeWorkItems(workItemA /*to*/, workItemB /*from*/);
-                }
+            // Search all work items against the states before merging. Merges only remove work items further down
+            // from the search and the merge target is never searched again, so a result stays valid unless the
+            // nearest work item itself was merged away.
+            const int32_t numWorkItems = (int32_t)vmWorkItems.Size() - 1;
+            vector<uint32_t> nearestWorkItem(numWorkItems, OmmWorkItems::kInvalidIndex, allocator);
+            #pragma omp parallel for schedule(dynamic, 1) if(options.enableInternalThreads)
+            for (int32_t itA = 0; itA < numWorkItems; ++itA)
+            {
+                if (IsCandidate(itA))
+                    nearestWorkItem[itA] = FindNearest(itA);
+            }
+
+            for (uint32_t itA = 0; itA < (uint32_t)numWorkItems; ++itA)
+            {
+                if (!IsCandidate(itA))
+                    continue;
+
+                uint32_t nearestIndex = nearestWorkItem[itA];
+                if (nearestIndex != OmmWorkItems::kInvalidIndex && vmWorkItems.HasSpecialIndex(nearestIndex))
+                    nearestIndex = FindNearest(itA);
+
+                if (nearestIndex != OmmWorkItems::kInvalidIndex)
+                    MergeWorkItems(vmWorkItems, itA /*to*/, nearestIndex /*from*/);
             }
 
             return ommResult_SUCCESS;
         }
 
-        static ommResult PromoteToSpecialIndices(const ommCpuBakeInputDesc& desc, const Options& options, vector<OmmWorkItem>& vmWorkItems)
+        static ommResult PromoteToSpecialIndices(const ommCpuBakeInputDesc& desc, const Options& options, OmmWorkItems& vmWorkItems)
         {
             // Collect raster output to a final VM state.
-            for (int32_t workItemIt = 0; workItemIt < vmWorkItems.size(); ++workItemIt)
+            for (uint32_t workItemIt = 0; workItemIt < vmWorkItems.Size(); ++workItemIt)
             {
-                OmmWorkItem& workItem = vmWorkItems[workItemIt];
-
-                if (workItem.HasSpecialIndex())
+                if (vmWorkItems.HasSpecialIndex(workItemIt))
                     continue;
 
-                const uint32_t numMicroTriangles = omm::bird::GetNumMicroTriangles(workItem.subdivisionLevel);
+                const OmmArrayDataVector& vmStates = vmWorkItems.vmStates[workItemIt];
+                const uint32_t numMicroTriangles = omm::bird::GetNumMicroTriangles(vmWorkItems.subdivisionLevel[workItemIt]);
 
-                bool allEqual = true;
-                ommOpacityState commonState = workItem.vmStates.GetState(0);
-                for (uint32_t uTriIt = 1; uTriIt < numMicroTriangles; ++uTriIt) {
-                    allEqual &= commonState == workItem.vmStates.GetState(uTriIt);
-                }
+                ommOpacityState commonState;
+                bool allEqual = vmStates.IsUniform(commonState);
 
                 if (!allEqual && desc.rejectionThreshold > 0.f)
                 {
                     // Reject "poor" VMs:
                     uint32_t known = 0;
                     for (uint32_t uTriIt = 0; uTriIt < numMicroTriangles; ++uTriIt) {
-                        if (IsKnown(workItem.vmStates.GetState(uTriIt)))
+                        if (IsKnown(vmStates.GetState(uTriIt)))
                             known++;
                     }
 
@@ -1465,19 +2784,20 @@ namespace Cpu
                 }
 
                 if (allEqual && !options.disableSpecialIndices) {
-                    workItem.vmSpecialIndex = -int32_t(commonState) - 1;
+                    vmWorkItems.vmSpecialIndex[workItemIt] = -int32_t(commonState) - 1;
                 }
             }
             return ommResult_SUCCESS;
         }
 
-        static ommResult ComputeKnownStates(const OmmWorkItem& item, uint32_t& known, uint32_t& total)
+        static ommResult ComputeKnownStates(const OmmWorkItems& vmWorkItems, uint32_t item, uint32_t& known, uint32_t& total)
         {
+            const OmmArrayDataVector& vmStates = vmWorkItems.vmStates[item];
             known = 0;
-            total = omm::bird::GetNumMicroTriangles(item.subdivisionLevel);
+            total = omm::bird::GetNumMicroTriangles(vmWorkItems.subdivisionLevel[item]);
             for (uint i = 0; i < total; ++i)
             {
-                ommOpacityState state0 = item.vmStates.Get3State(i);
+                ommOpacityState state0 = vmStates.Get3State(i);
 
                 if (IsKnown(state0))
                 {
@@ -1487,63 +2807,65 @@ namespace Cpu
             return ommResult_SUCCESS;
         }
 
-        static ommResult ComputeKnownRatio(const OmmWorkItem& item, float& knownRatio)
+        static ommResult ComputeKnownRatio(const OmmWorkItems& vmWorkItems, uint32_t item, float& knownRatio)
         {
             uint32_t known;
             uint32_t total;
-            RETURN_STATUS_IF_FAILED(ComputeKnownStates(item, known, total));
+            RETURN_STATUS_IF_FAILED(ComputeKnownStates(vmWorkItems, item, known, total));
             knownRatio = (float)known / total;
             return ommResult_SUCCESS;
         }
 
-        static ommResult DownsampleOneLevel(OmmWorkItem& item)
+        static ommResult DownsampleOneLevel(OmmWorkItems& vmWorkItems, uint32_t item)
         {
-            if (item.subdivisionLevel == 0)
+            if (vmWorkItems.subdivisionLevel[item] == 0)
                 return ommResult_FAILURE;
 
-            int subdivisionLevel = item.subdivisionLevel - 1;
-            item.subdivisionLevel = subdivisionLevel;
+            OmmArrayDataVector& vmStates = vmWorkItems.vmStates[item];
+            int subdivisionLevel = vmWorkItems.subdivisionLevel[item] - 1;
+            vmWorkItems.subdivisionLevel[item] = subdivisionLevel;
 
             const size_t numOmmForSubDivLvl = (size_t)omm::bird::GetNumMicroTriangles(subdivisionLevel);
 
             for (uint i = 0; i < numOmmForSubDivLvl; ++i)
             {
-                ommOpacityState state0 = item.vmStates.Get3State(4 * i);
-                ommOpacityState state1 = item.vmStates.Get3State(4 * i + 1);
-                ommOpacityState state2 = item.vmStates.Get3State(4 * i + 2);
-                ommOpacityState state3 = item.vmStates.Get3State(4 * i + 3);
+                ommOpacityState state0 = vmStates.Get3State(4 * i);
+                ommOpacityState state1 = vmStates.Get3State(4 * i + 1);
+                ommOpacityState state2 = vmStates.Get3State(4 * i + 2);
+                ommOpacityState state3 = vmStates.Get3State(4 * i + 3);
 
                 if (IsKnown(state0) && state0 == state1 && state0 == state2 && state0 == state3)
                 {
-                    item.vmStates.SetState(i, state0);
+                    vmStates.SetState(i, state0);
                 }
                 else
                 {
-                    item.vmStates.SetState(i, ommOpacityState_UnknownOpaque);
+                    vmStates.SetState(i, ommOpacityState_UnknownOpaque);
                 }
             }
 
-            item.vmStates.ShrinkTo(item.subdivisionLevel);
+            vmStates.ShrinkTo(subdivisionLevel);
 
             return ommResult_SUCCESS;
         }
 
-        static ommResult DownsampleOneLevel(const OmmWorkItem& item, float& knownRatio)
+        static ommResult DownsampleOneLevel(const OmmWorkItems& vmWorkItems, uint32_t item, float& knownRatio)
         {
-            if (item.subdivisionLevel == 0)
+            if (vmWorkItems.subdivisionLevel[item] == 0)
                 return ommResult_FAILURE;
 
-            int subdivisionLevel = item.subdivisionLevel - 1;
+            const OmmArrayDataVector& vmStates = vmWorkItems.vmStates[item];
+            int subdivisionLevel = vmWorkItems.subdivisionLevel[item] - 1;
 
             const size_t numOmmForSubDivLvl = (size_t)omm::bird::GetNumMicroTriangles(subdivisionLevel);
 
             uint32_t known = 0;
             for (uint i = 0; i < numOmmForSubDivLvl; ++i)
             {
-                ommOpacityState state0 = item.vmStates.Get3State(4 * i);
-                ommOpacityState state1 = item.vmStates.Get3State(4 * i + 1);
-                ommOpacityState state2 = item.vmStates.Get3State(4 * i + 2);
-                ommOpacityState state3 = item.vmStates.Get3State(4 * i + 3);
+                ommOpacityState state0 = vmStates.Get3State(4 * i);
+                ommOpacityState state1 = vmStates.Get3State(4 * i + 1);
+                ommOpacityState state2 = vmStates.Get3State(4 * i + 2);
+                ommOpacityState state3 = vmStates.Get3State(4 * i + 3);
 
                 if (IsKnown(state0) && state0 == state1 && state0 == state2 && state0 == state3)
                 {
@@ -1554,7 +2876,7 @@ namespace Cpu
             return ommResult_SUCCESS;
         }
 
-        static ommResult Compress(const StdAllocator<uint8_t>& allocator, const ommCpuBakeInputDesc& desc, const Options& options, vector<OmmWorkItem>& vmWorkItems)
+        static ommResult Compress(const StdAllocator<uint8_t>& allocator, const ommCpuBakeInputDesc& desc, const Options& options, OmmWorkItems& vmWorkItems)
         {
             if (desc.maxArrayDataSize == -1)
                 return ommResult_SUCCESS;
@@ -1569,24 +2891,27 @@ namespace Cpu
                 float coveragePerByte = 0.f;
             };
 
-            auto ComputeWorkItemInfo = [&desc](const OmmWorkItem& item, WorkItemInfo& outResult)->ommResult {
+            auto ComputeWorkItemInfo = [&desc, &vmWorkItems](uint32_t item, WorkItemInfo& outResult)->ommResult {
+
+                RETURN_STATUS_IF_FAILED(ComputeKnownRatio(vmWorkItems, item, outResult.knownRatio));
+                RETURN_STATUS_IF_FAILED(DownsampleOneLevel(vmWorkItems, item, outResult.knownRatioIfWeDownsample));
 
-                RETURN_STATUS_IF_FAILED(ComputeKnownRatio(item, outResult.knownRatio));
-                RETURN_STATUS_IF_FAILED(DownsampleOneLevel(item, outResult.knownRatioIfWeDownsample));
+                const Triangle& itemUvTri = vmWorkItems.uvTri[item];
+                const uint32_t subdivisionLevel = vmWorkItems.subdivisionLevel[item];
 
                 outResult.totalArea = 0;
-                for (uint32_t i : item.primitiveIndices)
+                vmWorkItems.ForEachPrimitive(item, [&](uint32_t i)
                 {
                     const Triangle uvTri = GetTriangle(desc, i);
-                    const float area = GetArea2D(item.uvTri);
+                    const float area = GetArea2D(itemUvTri);
                     OMM_ASSERT(area >= 0);
                     outResult.totalArea += area;
-                }
+                });
 
                // const float area = GetArea2D(item.uvTri);
                // outResult.totalArea = item.primitiveIndices.size() * area; // TODO: might need to consider that primitives have different sizes?
-                outResult.totalMemory = std::max<size_t>(1, (omm::bird::GetNumMicroTriangles(item.subdivisionLevel) * 2) / 8);
-                outResult.totalMemoryIfWeDownsample = std::max<size_t>(1, (omm::bird::GetNumMicroTriangles(item.subdivisionLevel - 1) * 2) / 8);
+                outResult.totalMemory = std::max<size_t>(1, (omm::bird::GetNumMicroTriangles(subdivisionLevel) * 2) / 8);
+                outResult.totalMemoryIfWeDownsample = std::max<size_t>(1, (omm::bird::GetNumMicroTriangles(subdivisionLevel - 1) * 2) / 8);
 
                 size_t memDelta = outResult.totalMemory - outResult.totalMemoryIfWeDownsample;
                 float coverageDelta = outResult.knownRatio - outResult.knownRatioIfWeDownsample;
@@ -1595,18 +2920,17 @@ namespace Cpu
             };
 
             vector<std::pair<int, WorkItemInfo>> activeItems(allocator);
-            for (int i = 0; i < (int)vmWorkItems.size(); ++i)
+            for (int i = 0; i < (int)vmWorkItems.Size(); ++i)
             {
-                const OmmWorkItem& item = vmWorkItems[i];
-                if (item.subdivisionLevel == 0)
+                if (vmWorkItems.subdivisionLevel[i] == 0)
                     continue;
-                if (item.primitiveIndices.size() == 0)
+                if (vmWorkItems.GetPrimitiveCount(i) == 0)
                     continue;
-                if (item.HasSpecialIndex())
+                if (vmWorkItems.HasSpecialIndex(i))
                     continue;
 
                 WorkItemInfo info;
-                RETURN_STATUS_IF_FAILED(ComputeWorkItemInfo(item, info));
+                RETURN_STATUS_IF_FAILED(ComputeWorkItemInfo(i, info));
 
                 activeItems.push_back(std::make_pair(i, info));
             }
@@ -1631,15 +2955,15 @@ namespace Cpu
                 int N = (int)activeItems.size();
                 for (int i = 0; i < N; ++i)
                 {
-                    OmmWorkItem& item = vmWorkItems[activeItems[i].first];
+                    const uint32_t item = (uint32_t)activeItems[i].first;
 
                     totalMemory -= activeItems[i].second.totalMemory;
 
-                    RETURN_STATUS_IF_FAILED(DownsampleOneLevel(item));
+                    RETURN_STATUS_IF_FAILED(DownsampleOneLevel(vmWorkItems, item));
                     
                     totalMemory += activeItems[i].second.totalMemoryIfWeDownsample;
 
-                    if (item.subdivisionLevel == 0)
+                    if (vmWorkItems.subdivisionLevel[item] == 0)
                     {
                         // remove from active list
                         activeItems[i].first = -1;
@@ -1655,8 +2979,8 @@ namespace Cpu
 
                     if (i + 1 != N)
                     {
-                        const OmmWorkItem& nextTtem = vmWorkItems[activeItems[i + 1].first];
-                        size_t nextItemSize = std::max<size_t>(1, (omm::bird::GetNumMicroTriangles(nextTtem.subdivisionLevel) * 2) / 8);
+                        const uint32_t nextItem = (uint32_t)activeItems[i + 1].first;
+                        size_t nextItemSize = std::max<size_t>(1, (omm::bird::GetNumMicroTriangles(vmWorkItems.subdivisionLevel[nextItem]) * 2) / 8);
 
                         if (activeItems[i].second.coveragePerByte < activeItems[i + 1].second.coveragePerByte)
                         {
@@ -1687,24 +3011,24 @@ namespace Cpu
             return ommResult_SUCCESS;
         }
 
-        static ommResult CreateUsageHistograms(vector<OmmWorkItem>& vmWorkItems, VisibilityMapUsageHistogram& arrayHistogram, VisibilityMapUsageHistogram& indexHistogram)
+        static ommResult CreateUsageHistograms(const OmmWorkItems& vmWorkItems, VisibilityMapUsageHistogram& arrayHistogram, VisibilityMapUsageHistogram& indexHistogram)
         {
             // Collect raster output to a final VM state.
-            for (int32_t workItemIt = 0; workItemIt < vmWorkItems.size(); ++workItemIt)
+            for (uint32_t workItemIt = 0; workItemIt < vmWorkItems.Size(); ++workItemIt)
             {
-                OmmWorkItem& workItem = vmWorkItems[workItemIt];
-
-                if (workItem.vmSpecialIndex == OmmWorkItem::kNoSpecialIndex)
+                if (!vmWorkItems.HasSpecialIndex(workItemIt))
                 {
                     // Must allocate vm-
-                    arrayHistogram.Inc(workItem.vmFormat, workItem.subdivisionLevel, 1 /*vm count*/);
-                    indexHistogram.Inc(workItem.vmFormat, workItem.subdivisionLevel, (uint32_t)workItem.primitiveIndices.size() /*vm count*/);
+                    const ommFormat vmFormat = vmWorkItems.vmFormat[workItemIt];
+                    const uint32_t subdivisionLevel = vmWorkItems.subdivisionLevel[workItemIt];
+                    arrayHistogram.Inc(vmFormat, subdivisionLevel, 1 /*vm count*/);
+                    indexHistogram.Inc(vmFormat, subdivisionLevel, vmWorkItems.GetPrimitiveCount(workItemIt) /*vm count*/);
                 }
             }
             return ommResult_SUCCESS;
         }
 
-        static ommResult MicromapSpatialSort(const StdAllocator<uint8_t>& allocator, const Options& options, const vector<OmmWorkItem>& vmWorkItems,
+        static ommResult MicromapSpatialSort(const StdAllocator<uint8_t>& allocator, const Options& options, const OmmWorkItems& vmWorkItems,
             vector<std::pair<uint64_t, uint32_t>>& sortKeys)
         {
             // The VMs should be sorted to respect the following rules:
@@ -1716,13 +3040,12 @@ namespace Cpu
 
             static constexpr uint32_t kTargetDeviceCacheLineSize = 128;
 
-            sortKeys.resize(vmWorkItems.size());
+            sortKeys.resize(vmWorkItems.Size());
             {
                 #pragma omp parallel for if(options.enableInternalThreads)
-                for (int32_t vmIndex = 0; vmIndex < vmWorkItems.size(); ++vmIndex) {
+                for (int32_t vmIndex = 0; vmIndex < (int32_t)vmWorkItems.Size(); ++vmIndex) {
 
-                    const OmmWorkItem& vm = vmWorkItems[vmIndex];
-                    if (vm.vmSpecialIndex != OmmWorkItem::kNoSpecialIndex)
+                    if (vmWorkItems.HasSpecialIndex(vmIndex))
                     {
                         // For special indices, maintain original order.
                         uint64_t key = (1ull << 63) | (uint64_t)vmIndex;
@@ -1733,7 +3056,8 @@ namespace Cpu
                         // Order VMs in Morton-order in UV-space. 
                         constexpr const uint32_t k = 13;
                         const int2 qSize = int2(1u << k, 1u << k);
-                        const int2 qUV = int2(float2(qSize) * ((vm.uvTri.p0 + vm.uvTri.p1 + vm.uvTri.p2) / 3.f));
+                        const Triangle& uvTri = vmWorkItems.uvTri[vmIndex];
+                        const int2 qUV = int2(float2(qSize) * ((uvTri.p0 + uvTri.p1 + uvTri.p2) / 3.f));
                         const int2 qPosMirrored = GetTexCoord<ommTextureAddressMode_MirrorOnce, false>(qUV, qSize, {0,0});
                         OMM_ASSERT(qPosMirrored.x >= 0 && qPosMirrored.y >= 0);
                         const uint64_t mCode = xy_to_morton(qPosMirrored.x, qPosMirrored.y);
@@ -1742,7 +3066,7 @@ namespace Cpu
 
                         // First sort on sub-div lvl.
                         uint64_t key = 0;
-                        key |= (uint64_t)vm.subdivisionLevel << 60;
+                        key |= (uint64_t)vmWorkItems.subdivisionLevel[vmIndex] << 60;
                         key |= mCode;
                         sortKeys[vmIndex] = std::make_pair(key, vmIndex);
                     }
@@ -1755,7 +3079,7 @@ namespace Cpu
 
         static ommResult Serialize(
             const StdAllocator<uint8_t>& allocator, 
-            const ommCpuBakeInputDesc& desc, const Options& options, vector<OmmWorkItem>& vmWorkItems, const VisibilityMapUsageHistogram& ommArrayHistogram, const VisibilityMapUsageHistogram& ommIndexHistogram,
+            const ommCpuBakeInputDesc& desc, const Options& options, OmmWorkItems& vmWorkItems, const VisibilityMapUsageHistogram& ommArrayHistogram, const VisibilityMapUsageHistogram& ommIndexHistogram,
             const vector<std::pair<uint64_t, uint32_t>>& sortKeys,
             BakeResultImpl& res)
         {
@@ -1786,33 +3110,43 @@ namespace Cpu
                     uint32_t prevSubDivLvl = 0;
                     uint32_t vmDescOffset = 0;
                     for (auto [_, vmIndex] : sortKeys) {
-                        OmmWorkItem& vm = vmWorkItems[vmIndex];
-
-                        if (vm.vmSpecialIndex == OmmWorkItem::kNoSpecialIndex)
+                        if (!vmWorkItems.HasSpecialIndex(vmIndex))
                         {
                             if (ommArrayDataOffset >= ommArrayDataSize)
                                 return ommResult_FAILURE;
 
                             // Fill Desc Info
-                            res.ommDescArray[vmDescOffset].subdivisionLevel = vm.subdivisionLevel;
-                            res.ommDescArray[vmDescOffset].format = (uint16_t)vm.vmFormat;
+                            const uint32_t subdivisionLevel = vmWorkItems.subdivisionLevel[vmIndex];
+                            const ommFormat vmFormat = vmWorkItems.vmFormat[vmIndex];
+                            const OmmArrayDataVector& vmStates = vmWorkItems.vmStates[vmIndex];
+
+                            res.ommDescArray[vmDescOffset].subdivisionLevel = subdivisionLevel;
+                            res.ommDescArray[vmDescOffset].format = (uint16_t)vmFormat;
                             res.ommDescArray[vmDescOffset].offset = ommArrayDataOffset;
-                            vm.vmDescOffset = vmDescOffset++;
+                            vmWorkItems.vmDescOffset[vmIndex] = vmDescOffset++;
 
-                            const uint32_t numMicroTriangles = bird::GetNumMicroTriangles(vm.subdivisionLevel);
+                            const uint32_t numMicroTriangles = bird::GetNumMicroTriangles(subdivisionLevel);
 
                             uint8_t* ommArrayDataPtr = res.ommArrayData.data() + ommArrayDataOffset;
-                            const uint32_t is2State = vm.vmFormat == ommFormat_OC1_2_State;
-                            for (uint32_t uTriIt = 0; uTriIt < numMicroTriangles; ++uTriIt)
+                            const uint32_t is2State = vmFormat == ommFormat_OC1_2_State;
+                            if (is2State)
                             {
-                                uint32_t state = ((uint32_t)vm.vmStates.GetState(uTriIt));
-
-                                uint8_t val;
-                                if (is2State)   val = state << ((uTriIt & 7));
-                                else            val = state << ((uTriIt & 3) << 1u);
-
-                                uint32_t byteIndex = uTriIt >> (2 + is2State);
-                                ommArrayDataPtr[byteIndex] |= val;
+                                for (uint32_t uTriIt = 0; uTriIt < numMicroTriangles; ++uTriIt)
+                                {
+                                    uint32_t state = ((uint32_t)vmStates.GetState(uTriIt));
+                                    ommArrayDataPtr[uTriIt >> 3] |= state << (uTriIt & 7);
+                                }
+                            }
+                            else
+                            {
+                                // The packed states already use the 4-state layout, copy byte by byte.
+                                const uint32_t numBytes = std::max((numMicroTriangles * 2u) >> 3u, 1u);
+                                for (uint32_t byteIt = 0; byteIt < numBytes; ++byteIt)
+                                    ommArrayDataPtr[byteIt] = vmStates.GetByte(byteIt);
+
+                                // Level 0 only uses the two low bits.
+                                if (numMicroTriangles < 4)
+                                    ommArrayDataPtr[0] &= (uint8_t)((1u << (numMicroTriangles * 2u)) - 1u);
                             }
 
                             // Offsets must be at least 1B aligned.
@@ -1857,15 +3191,13 @@ namespace Cpu
             {
                 res.ommIndexBuffer.resize(triangleCount);
                 std::fill(res.ommIndexBuffer.begin(), res.ommIndexBuffer.end(), (int32_t)desc.unresolvedTriState);
-                for (const OmmWorkItem& vm : vmWorkItems) 
+                for (uint32_t vmIndex = 0; vmIndex < vmWorkItems.Size(); ++vmIndex) 
 				{
-                    for (uint32_t primitiveIndex : vm.primitiveIndices)
+                    const int32_t index = (int32_t)(vmWorkItems.HasSpecialIndex(vmIndex) ? vmWorkItems.vmSpecialIndex[vmIndex] : vmWorkItems.vmDescOffset[vmIndex]);
+                    vmWorkItems.ForEachPrimitive(vmIndex, [&](uint32_t primitiveIndex)
                     {
-                        if (vm.vmSpecialIndex != OmmWorkItem::kNoSpecialIndex)
-                            res.ommIndexBuffer[primitiveIndex] = vm.vmSpecialIndex;
-                        else
-                            res.ommIndexBuffer[primitiveIndex] = vm.vmDescOffset;
-                    }
+                        res.ommIndexBuffer[primitiveIndex] = index;
+                    });
                 }
             }
 
@@ -1890,14 +3222,14 @@ namespace Cpu
 
             {
                 res.ommTriangleArea.resize(triangleCount);
-                for (const OmmWorkItem& item : vmWorkItems)
+                for (uint32_t vmIndex = 0; vmIndex < vmWorkItems.Size(); ++vmIndex)
                 {
-                    for (uint32_t primitiveIndex : item.primitiveIndices)
+                    vmWorkItems.ForEachPrimitive(vmIndex, [&](uint32_t primitiveIndex)
                     {
                         const Triangle uvTri = GetTriangle(desc, primitiveIndex);
 
                         res.ommTriangleArea[primitiveIndex] = GetArea2D(uvTri);
-                    }
+                    });
                 }
             }
 
@@ -1916,30 +3248,39 @@ namespace Cpu
 
         m_bakeInputDesc = desc;
 
-        auto impl__ResampleCoarse = [](const ommCpuBakeInputDesc& desc, const Logger& log, const Options& options, vector<OmmWorkItem>& vmWorkItems) {
-            return impl::ResampleCoarse<eFormat, eTilingMode, eTextureAddressMode, eFilterMode, bTexIsPow2>(desc, log, options, vmWorkItems);
+        auto impl__ResampleCoarse = [](const ommCpuBakeInputDesc& desc, const Logger& log, const Options& options, OmmWorkItems& vmWorkItems, impl::ResampleSchedule& schedule) {
+            return impl::ResampleCoarse<eFormat, eTilingMode, eTextureAddressMode, eFilterMode, bTexIsPow2>(desc, log, options, vmWorkItems, schedule);
         };
 
-        auto impl__ResampleFineNormal = [](const ommCpuBakeInputDesc& desc, const Logger& log, const Options& options, vector<OmmWorkItem>& vmWorkItems) {
-            return impl::ResampleFine<eFormat, eTilingMode, eTextureAddressMode, eFilterMode, impl::TriangleClass::Normal, bTexIsPow2>(desc, log, options, vmWorkItems);
+        auto impl__ResampleFineNormal = [](const ommCpuBakeInputDesc& desc, const Logger& log, const Options& options, OmmWorkItems& vmWorkItems, impl::ResampleSchedule& schedule) {
+            return impl::ResampleFine<eFormat, eTilingMode, eTextureAddressMode, eFilterMode, impl::TriangleClass::Normal, bTexIsPow2>(desc, log, options, vmWorkItems, schedule);
         };
 
-        auto impl__ResampleFineDegen = [](const ommCpuBakeInputDesc& desc, const Logger& log, const Options& options, vector<OmmWorkItem>& vmWorkItems) {
-            return impl::ResampleFine<eFormat, eTilingMode, eTextureAddressMode, eFilterMode, impl::TriangleClass::Degenerate, bTexIsPow2>(desc, log, options, vmWorkItems);
+        auto impl__ResampleFineDegen = [](const ommCpuBakeInputDesc& desc, const Logger& log, const Options& options, OmmWorkItems& vmWorkItems, impl::ResampleSchedule& schedule) {
+            return impl::ResampleFine<eFormat, eTilingMode, eTextureAddressMode, eFilterMode, impl::TriangleClass::Degenerate, bTexIsPow2>(desc, log, options, vmWorkItems, schedule);
         };
 
         {
-            vector<OmmWorkItem> vmWorkItems(m_stdAllocator.GetInterface());
+            OmmArrayDataPool statePool(m_stdAllocator, options.enableInternalThreads);
+            OmmWorkItems vmWorkItems(m_stdAllocator);
 
-            RETURN_STATUS_IF_FAILED(impl::SetupWorkItems(m_stdAllocator, m_log, desc, options, vmWorkItems));
+            RETURN_STATUS_IF_FAILED(impl::SetupWorkItems(m_stdAllocator, m_log, desc, options, statePool, vmWorkItems));
 
             RETURN_STATUS_IF_FAILED(impl::ValidateWorkloadSize(m_stdAllocator, m_log, desc, options, vmWorkItems));
 
-            RETURN_STATUS_IF_FAILED(impl__ResampleCoarse(desc, m_log, options, vmWorkItems));
+            impl::ResampleSchedule schedule(m_stdAllocator, options);
+            schedule.Setup(desc, vmWorkItems);
+
+            RETURN_STATUS_IF_FAILED(impl__ResampleCoarse(desc, m_log, options, vmWorkItems, schedule));
+
+            RETURN_STATUS_IF_FAILED(impl__ResampleFineNormal(desc, m_log, options, vmWorkItems, schedule));
+
+            RETURN_STATUS_IF_FAILED(impl__ResampleFineDegen(desc, m_log, options, vmWorkItems, schedule));
 
-            RETURN_STATUS_IF_FAILED(impl__ResampleFineNormal(desc, m_log, options, vmWorkItems));
+            RETURN_STATUS_IF_FAILED(impl::ResolveRotatedWorkItems(options, vmWorkItems));
 
-            RETURN_STATUS_IF_FAILED(impl__ResampleFineDegen(desc, m_log, options, vmWorkItems));
+            m_bakeResult.threadUtilization = schedule.GetThreadUtilization();
+            m_bakeResult.texCoordQuantization = std::max(desc.texCoordQuantization, 0.f);
 
             RETURN_STATUS_IF_FAILED(impl::PromoteToSpecialIndices(desc, options, vmWorkItems));
 
@@ -66,6 +66,8 @@ namespace Cpu
         vector<ommCpuOpacityMicromapUsageCount> ommArrayHistogram;
         vector<ommCpuOpacityMicromapUsageCount> ommIndexHistogram;
         vector<float> ommTriangleArea; // used for debug info and stats
+        float threadUtilization = -1.f; // used for debug stats
+        float texCoordQuantization = -1.f; // used for debug stats
         ommCpuBakeResultDesc bakeOutputDesc = {0,};
 
         BakeResultImpl(const StdAllocator<uint8_t>& stdAllocator) :
@@ -125,6 +127,18 @@ namespace Cpu
             return ommResult_SUCCESS;
         }
 
+        inline ommResult GetBakeResultThreadUtilization(float& threadUtilization) const
+        {
+            threadUtilization = m_bakeResult.threadUtilization;
+            return ommResult_SUCCESS;
+        }
+
+        inline ommResult GetBakeResultTexCoordQuantization(float& texCoordQuantization) const
+        {
+            texCoordQuantization = m_bakeResult.texCoordQuantization;
+            return ommResult_SUCCESS;
+        }
+
         ommResult Bake(const ommCpuBakeInputDesc& desc);
 
     private:
@@ -22,6 +22,13 @@ struct OmmCoverage
     uint32_t numBelowAlpha = 0;
 };
 
+// Coverage kernels return false to stop the raster. Once coverage is mixed the state can only be unknown, further
+// texels only matter when the unknown state is promoted by comparing the counts (ommUnknownStatePromotion_Nearest).
+static bool ShouldContinueRaster(const OmmCoverage& coverage, bool stopOnMixedCoverage)
+{
+    return !stopOnMixedCoverage || coverage.numAboveAlpha == 0 || coverage.numBelowAlpha == 0;
+}
+
 static ommOpacityState GetStateFromCoverage(ommFormat vmFormat, ommUnknownStatePromotion mode, ommOpacityState alphaCutoffGT, ommOpacityState alphaCutoffLE, const OmmCoverage& coverage)
 {
     const bool isUnknown = coverage.numAboveAlpha != 0 && coverage.numBelowAlpha != 0;
@@ -60,6 +67,10 @@ static ommOpacityState GetStateFromCoverage(ommFormat vmFormat, ommUnknownStateP
     }
 };
 
+// Kernels expose run(pixel, ctx) for callers passing a function pointer and Params through the raster context, and
+// Functor, which holds the Params by value. Passed as a functor the kernel is inlined into the scan loop and loop
+// invariants such as the texture, its size and the cutoff stay in registers.
+
 // ~~~~~~ LevelLineIntersectionKernel ~~~~~~ 
 // 
 struct LevelLineIntersectionKernel
@@ -73,6 +84,7 @@ struct LevelLineIntersectionKernel
         float                   alphaCutoff;
         float                   borderAlpha;
         uint32_t                mipLevel;
+        bool                    stopOnMixedCoverage;
     };
 
 private:
@@ -239,9 +251,8 @@ private:
 public:
 
     template<ommCpuTextureFormat eFormat, ommTextureAddressMode eTextureAddressMode, TilingMode eTilingMode, bool bIsDegenerate, bool bTexIsPow2>
-    static void run(int2 pixel, void* ctx)
+    static bool Eval(int2 pixel, const Params* p)
     {
-        Params* p = (Params*)ctx;
 
         const float2& invSize = p->texture->GetRcpSize(p->mipLevel);
 
@@ -326,7 +337,7 @@ public:
             // We've already concluded it's unknown -> return!
             if (IsOpaque && IsTransparent)
             {
-                return;
+                return ShouldContinueRaster(*p->vmCoverage, p->stopOnMixedCoverage);
             }
         }
 
@@ -396,7 +407,26 @@ public:
                 
             }
         }
+
+        return ShouldContinueRaster(*p->vmCoverage, p->stopOnMixedCoverage);
+    }
+
+    template<ommCpuTextureFormat eFormat, ommTextureAddressMode eTextureAddressMode, TilingMode eTilingMode, bool bIsDegenerate, bool bTexIsPow2>
+    static bool run(int2 pixel, void* ctx)
+    {
+        return Eval<eFormat, eTextureAddressMode, eTilingMode, bIsDegenerate, bTexIsPow2>(pixel, (const Params*)ctx);
     }
+
+    template<ommCpuTextureFormat eFormat, ommTextureAddressMode eTextureAddressMode, TilingMode eTilingMode, bool bIsDegenerate, bool bTexIsPow2>
+    struct Functor
+    {
+        Params params;
+
+        bool operator()(int2 pixel, void*) const
+        {
+            return Eval<eFormat, eTextureAddressMode, eTilingMode, bIsDegenerate, bTexIsPow2>(pixel, &params);
+        }
+    };
 };
 
 // ~~~~~~ ConservativeBilinearKernel ~~~~~~ 
@@ -412,15 +442,15 @@ struct ConservativeBilinearKernel
         float                   alphaCutoff;
         float                   borderAlpha;
         uint32_t                mipLevel;
+        bool                    stopOnMixedCoverage;
     };
 
     template<ommCpuTextureFormat eFormat, ommTextureAddressMode eTextureAddressMode, TilingMode eTilingMode, bool bTexIsPow2>
-    static void run(int2 pixel, void* ctx)
+    static bool Eval(int2 pixel, const Params* p)
     {
         // We add +0.5 here in order to compensate for the raster offset.
         const float2 pixelf = (float2)pixel + 0.5f;
 
-        Params* p = (Params*)ctx;
         int2 coord[TexelOffset::MAX_NUM];
         omm::GatherTexCoord4<eTextureAddressMode, bTexIsPow2>(int2(pixelf), p->size, p->sizeLog2, coord);
 
@@ -448,6 +478,175 @@ struct ConservativeBilinearKernel
         {
             p->vmCoverage->numBelowAlpha += 1;
         }
+
+        return ShouldContinueRaster(*p->vmCoverage, p->stopOnMixedCoverage);
+    }
+
+    template<ommCpuTextureFormat eFormat, ommTextureAddressMode eTextureAddressMode, TilingMode eTilingMode, bool bTexIsPow2>
+    static bool run(int2 pixel, void* ctx)
+    {
+        return Eval<eFormat, eTextureAddressMode, eTilingMode, bTexIsPow2>(pixel, (const Params*)ctx);
+    }
+
+    template<ommCpuTextureFormat eFormat, ommTextureAddressMode eTextureAddressMode, TilingMode eTilingMode, bool bTexIsPow2>
+    struct Functor
+    {
+        Params params;
+
+        bool operator()(int2 pixel, void*) const
+        {
+            return Eval<eFormat, eTextureAddressMode, eTilingMode, bTexIsPow2>(pixel, &params);
+        }
+    };
+};
+
+// ~~~~~~ BilinearBoundsKernel ~~~~~~
+// Bounds the bilinear interpolation over a texel footprint by its four interpolants. Coverage that is not mixed
+// guarantees the interpolated alpha is on the same side of the cutoff everywhere inside the rasterized triangle.
+struct BilinearBoundsKernel
+{
+    using Params = ConservativeBilinearKernel::Params;
+
+    template<ommCpuTextureFormat eFormat, ommTextureAddressMode eTextureAddressMode, TilingMode eTilingMode, bool bTexIsPow2>
+    static bool Eval(int2 pixel, const Params* p)
+    {
+        int2 coord00, coord10, coord01, coord11;
+        omm::GatherTexCoord4<eTextureAddressMode, bTexIsPow2>(pixel, p->size, p->sizeLog2, coord00, coord10, coord01, coord11);
+
+        auto IsBorder = [](int2 coord) {
+            return eTextureAddressMode == ommTextureAddressMode_Border && (coord.x == kTexCoordBorder || coord.y == kTexCoordBorder);
+        };
+
+        // The embedded cutoff fixes the side of every texel, its opacity bits replace loading and comparing the alphas.
+        if (p->texture->HasSAT())
+        {
+            auto IsAbove = [p, IsBorder](int2 coord) {
+                return IsBorder(coord) ? p->alphaCutoff < p->borderAlpha : p->texture->IsAboveAlphaCutoff(coord, p->mipLevel);
+            };
+
+            const bool isAbove00 = IsAbove(coord00);
+            const bool isAbove10 = IsAbove(coord10);
+            const bool isAbove01 = IsAbove(coord01);
+            const bool isAbove11 = IsAbove(coord11);
+
+            p->vmCoverage->numAboveAlpha += isAbove00 | isAbove10 | isAbove01 | isAbove11;
+            p->vmCoverage->numBelowAlpha += !(isAbove00 & isAbove10 & isAbove01 & isAbove11);
+
+            return ShouldContinueRaster(*p->vmCoverage, p->stopOnMixedCoverage);
+        }
+
+        const float a00 = IsBorder(coord00) ? p->borderAlpha : p->texture->Load<eFormat, eTilingMode>(coord00, p->mipLevel);
+        const float a10 = IsBorder(coord10) ? p->borderAlpha : p->texture->Load<eFormat, eTilingMode>(coord10, p->mipLevel);
+        const float a01 = IsBorder(coord01) ? p->borderAlpha : p->texture->Load<eFormat, eTilingMode>(coord01, p->mipLevel);
+        const float a11 = IsBorder(coord11) ? p->borderAlpha : p->texture->Load<eFormat, eTilingMode>(coord11, p->mipLevel);
+
+        const float min = std::min(std::min(a00, a10), std::min(a01, a11));
+        const float max = std::max(std::max(a00, a10), std::max(a01, a11));
+
+        // Matches the level line kernel, alpha equal to the cutoff counts as below.
+        p->vmCoverage->numAboveAlpha += p->alphaCutoff < max;
+        p->vmCoverage->numBelowAlpha += !(p->alphaCutoff < min);
+
+        return ShouldContinueRaster(*p->vmCoverage, p->stopOnMixedCoverage);
+    }
+
+    template<ommCpuTextureFormat eFormat, ommTextureAddressMode eTextureAddressMode, TilingMode eTilingMode, bool bTexIsPow2>
+    static bool run(int2 pixel, void* ctx)
+    {
+        return Eval<eFormat, eTextureAddressMode, eTilingMode, bTexIsPow2>(pixel, (const Params*)ctx);
+    }
+
+    template<ommCpuTextureFormat eFormat, ommTextureAddressMode eTextureAddressMode, TilingMode eTilingMode, bool bTexIsPow2>
+    struct Functor
+    {
+        Params params;
+
+        bool operator()(int2 pixel, void*) const
+        {
+            return Eval<eFormat, eTextureAddressMode, eTilingMode, bTexIsPow2>(pixel, &params);
+        }
+    };
+
+    // Every pixel in [tileMin, tileMax] gathers texels [pixel, pixel + 1], a SAT count of 0 or all of the footprint
+    // means each of them would add one to the same side of the cutoff.
+    static TileResult runTile(int2 tileMin, int2 tileMax, void* ctx)
+    {
+        Params* p = (Params*)ctx;
+        const int2 footprintMax = tileMax + 1;
+        if (!p->texture->HasSAT() || !p->texture->InTexture(tileMin, p->mipLevel) || !p->texture->InTexture(footprintMax, p->mipLevel))
+            return TileResult::PerPixel;
+
+        const int2 footprint = footprintMax - tileMin + 1;
+        const uint32_t numAbove = p->texture->SAT(tileMin, footprintMax, p->mipLevel);
+        const int2 tileSize = tileMax - tileMin + 1;
+        const uint32_t numPixels = (uint32_t)(tileSize.x * tileSize.y);
+
+        if (numAbove == 0)
+            p->vmCoverage->numBelowAlpha += numPixels;
+        else if (numAbove == (uint32_t)(footprint.x * footprint.y))
+            p->vmCoverage->numAboveAlpha += numPixels;
+        else
+            return TileResult::PerPixel;
+
+        return ShouldContinueRaster(*p->vmCoverage, p->stopOnMixedCoverage) ? TileResult::Handled : TileResult::Terminate;
+    }
+};
+
+// ~~~~~~ NearestKernel ~~~~~~
+// Counts the texels a conservative raster of the triangle touches on each side of the cutoff, for nearest filtering. With
+// bUseSAT the sides are read from the opacity bits of the embedded cutoff instead of loading and comparing the alphas.
+struct NearestKernel
+{
+    struct Params
+    {
+        OmmCoverage*            vmCoverage;
+        int2                    size;
+        int2                    sizeLog2;
+        const TextureImpl*      texture;
+        float                   alphaCutoff;
+        float                   borderAlpha;
+        uint32_t                mipLevel;
+        bool                    stopOnMixedCoverage;
+    };
+
+    template<ommCpuTextureFormat eFormat, ommTextureAddressMode eTextureAddressMode, TilingMode eTilingMode, bool bTexIsPow2, bool bUseSAT>
+    static bool run(int2 pixel, void* ctx)
+    {
+        const Params* p = (const Params*)ctx;
+        const int2 coord = omm::GetTexCoord<eTextureAddressMode, bTexIsPow2>(pixel, p->size, p->sizeLog2);
+
+        const bool isBorder = eTextureAddressMode == ommTextureAddressMode_Border && (coord.x == kTexCoordBorder || coord.y == kTexCoordBorder);
+
+        bool isAbove;
+        if (isBorder)
+            isAbove = p->alphaCutoff < p->borderAlpha;
+        else if constexpr (bUseSAT)
+            isAbove = p->texture->IsAboveAlphaCutoff(coord, p->mipLevel);
+        else
+            isAbove = p->alphaCutoff < p->texture->template Load<eFormat, eTilingMode>(coord, p->mipLevel);
+
+        p->vmCoverage->numAboveAlpha += isAbove;
+        p->vmCoverage->numBelowAlpha += !isAbove;
+
+        return ShouldContinueRaster(*p->vmCoverage, p->stopOnMixedCoverage);
+    }
+
+    // Texels of a tile inside the texture are the tile itself and match a block of the opacity mask, one popcount
+    // counts the covered texels on each side of the cutoff. Only used with bUseSAT.
+    static TileResult runTile(int2 tileMin, int2 tileMax, uint64_t coverage, void* ctx)
+    {
+        static_assert(kRasterTileSize == TextureImpl::kOpacityBlockSize);
+
+        Params* p = (Params*)ctx;
+        OMM_ASSERT(p->texture->HasSAT());
+        if (!p->texture->InTexture(tileMin, p->mipLevel) || !p->texture->InTexture(tileMax, p->mipLevel))
+            return TileResult::PerPixel;
+
+        const uint64_t opacity = p->texture->GetAlphaCutoffBlock(tileMin, p->mipLevel);
+        p->vmCoverage->numAboveAlpha += (uint32_t)std::popcount(coverage & opacity);
+        p->vmCoverage->numBelowAlpha += (uint32_t)std::popcount(coverage & ~opacity);
+
+        return ShouldContinueRaster(*p->vmCoverage, p->stopOnMixedCoverage) ? TileResult::Handled : TileResult::Terminate;
     }
 };
 
@@ -640,7 +640,7 @@ namespace omm
         return stats;
     }
 
-    ommResult GetStatsImpl(StdAllocator<uint8_t>& memoryAllocator, const ommCpuBakeResultDesc* resDesc, const float* area, ommDebugStats* out)
+    ommResult GetStatsImpl(StdAllocator<uint8_t>& memoryAllocator, const ommCpuBakeResultDesc* resDesc, const float* area, float threadUtilization, float texCoordQuantization, ommDebugStats* out)
     {
         if (resDesc == nullptr)
             return ommResult_INVALID_ARGUMENT;
@@ -648,6 +648,8 @@ namespace omm
             return ommResult_INVALID_ARGUMENT;
 
         *out = CollectStats(memoryAllocator, *resDesc, area);
+        out->threadUtilization = threadUtilization;
+        out->texCoordQuantization = texCoordQuantization;
         return ommResult_SUCCESS;
     }
 
@@ -18,7 +18,7 @@ namespace omm
 {
     OMM_API ommResult SaveAsImagesImpl(StdAllocator<uint8_t>& memoryAllocator, const ommCpuBakeInputDesc& bakeInputDesc, const ommCpuBakeResultDesc* res, const ommDebugSaveImagesDesc& desc);
 
-    OMM_API ommResult GetStatsImpl(StdAllocator<uint8_t>& memoryAllocator, const ommCpuBakeResultDesc* res, const float* area, ommDebugStats* out);
+    OMM_API ommResult GetStatsImpl(StdAllocator<uint8_t>& memoryAllocator, const ommCpuBakeResultDesc* res, const float* area, float threadUtilization, float texCoordQuantization, ommDebugStats* out);
 
     OMM_API ommResult SaveBinaryToDiskImpl(const Logger& log, const ommCpuBlobDesc& data, const char* path);
 }
@@ -83,7 +83,7 @@ namespace Cpu
     {
         std::ostream os(&buffer);
 
-        static_assert(sizeof(ommCpuBakeInputDesc) == 136);
+        static_assert(sizeof(ommCpuBakeInputDesc) == 144);
 
         os.write(reinterpret_cast<const char*>(&inputDesc.bakeFlags), sizeof(inputDesc.bakeFlags));
 
@@ -139,6 +139,7 @@ namespace Cpu
         }
 
         os.write(reinterpret_cast<const char*>(&inputDesc.maxWorkloadSize), sizeof(inputDesc.maxWorkloadSize));
+        os.write(reinterpret_cast<const char*>(&inputDesc.texCoordQuantization), sizeof(inputDesc.texCoordQuantization));
 
         return ommResult_SUCCESS;
     }
@@ -365,7 +366,7 @@ namespace Cpu
     {
         std::istream os(&buffer);
 
-        static_assert(sizeof(ommCpuBakeInputDesc) == 136);
+        static_assert(sizeof(ommCpuBakeInputDesc) == 144);
 
         os.read(reinterpret_cast<char*>(&inputDesc.bakeFlags), sizeof(inputDesc.bakeFlags));
 
@@ -439,6 +440,10 @@ namespace Cpu
         }
 
         os.read(reinterpret_cast<char*>(&inputDesc.maxWorkloadSize), sizeof(inputDesc.maxWorkloadSize));
+        if (header.inputDescVersion >= 5)
+        {
+            os.read(reinterpret_cast<char*>(&inputDesc.texCoordQuantization), sizeof(inputDesc.texCoordQuantization));
+        }
 
         if (texture->HasSAT() && header.inputDescVersion < 3)
         {
@@ -32,7 +32,9 @@ namespace omm
         m_data(nullptr),
         m_dataSize(0),
         m_dataSAT(nullptr),
-        m_dataSATSize(0)
+        m_dataSATSize(0),
+        m_dataAlphaRange(nullptr),
+        m_dataCutoffDistance(nullptr)
     {
     }
 
@@ -41,11 +43,76 @@ namespace omm
         Deallocate();
     }
 
+    static size_t GetSizePerPixel(ommCpuTextureFormat format)
+    {
+        if (format == ommCpuTextureFormat_UNORM8)
+            return sizeof(uint8_t);
+        else if (format == ommCpuTextureFormat_FP32)
+            return sizeof(float);
+        OMM_ASSERT(false);
+        return 0;
+    }
+
+    // Calls f.template operator()<eFormat, eTilingMode>() with the format and tiling mode as template arguments.
+    template<class TFunctor>
+    static void DispatchTexelLayout(ommCpuTextureFormat format, TilingMode tilingMode, TFunctor&& f)
+    {
+        if (format == ommCpuTextureFormat_FP32 && tilingMode == TilingMode::Linear)
+            f.template operator()<ommCpuTextureFormat_FP32, TilingMode::Linear>();
+        else if (format == ommCpuTextureFormat_FP32 && tilingMode == TilingMode::MortonZ)
+            f.template operator()<ommCpuTextureFormat_FP32, TilingMode::MortonZ>();
+        else if (format == ommCpuTextureFormat_FP32 && tilingMode == TilingMode::BlockLinear)
+            f.template operator()<ommCpuTextureFormat_FP32, TilingMode::BlockLinear>();
+        else if (format == ommCpuTextureFormat_UNORM8 && tilingMode == TilingMode::Linear)
+            f.template operator()<ommCpuTextureFormat_UNORM8, TilingMode::Linear>();
+        else if (format == ommCpuTextureFormat_UNORM8 && tilingMode == TilingMode::MortonZ)
+            f.template operator()<ommCpuTextureFormat_UNORM8, TilingMode::MortonZ>();
+        else if (format == ommCpuTextureFormat_UNORM8 && tilingMode == TilingMode::BlockLinear)
+            f.template operator()<ommCpuTextureFormat_UNORM8, TilingMode::BlockLinear>();
+        else
+            OMM_ASSERT(false);
+    }
+
+    // Copies rows of texels to a tiled layout. In Morton order the x bits of the index are stepped by carrying through the
+    // y bits instead of interleaving every texel.
+    template<TilingMode eTilingMode, size_t kSizePerPixel>
+    void TextureImpl::CopyToTiled(uint8_t* dst, const uint8_t* src, const int2& size, size_t srcRowPitch, bool enableInternalThreads)
+    {
+        #pragma omp parallel for if(enableInternalThreads)
+        for (int32_t j = 0; j < size.y; ++j)
+        {
+            const uint8_t* srcRow = src + j * srcRowPitch;
+            if constexpr (eTilingMode == TilingMode::MortonZ)
+            {
+                const uint32_t yBits = xy_to_morton(0, j);
+                uint32_t xBits = 0;
+                for (int32_t i = 0; i < size.x; ++i)
+                {
+                    std::memcpy(dst + size_t(xBits | yBits) * kSizePerPixel, srcRow + i * kSizePerPixel, kSizePerPixel);
+                    xBits = ((xBits | 0xAAAAAAAAu) + 1u) & 0x55555555u;
+                }
+            }
+            else
+            {
+                for (int32_t i = 0; i < size.x; ++i)
+                {
+                    const uint32_t idx = From2Dto1D<eTilingMode>(int2(i, j), size);
+                    std::memcpy(dst + size_t(idx) * kSizePerPixel, srcRow + i * kSizePerPixel, kSizePerPixel);
+                }
+            }
+        }
+    }
+
     ommResult TextureImpl::Validate(const ommCpuTextureDesc& desc) const {
         if (desc.mipCount == 0)
             return m_log.InvalidArg("[Invalid Arg] - mipCount must be non-zero");
         if (desc.format == ommCpuTextureFormat_MAX_NUM)
             return m_log.InvalidArg("[Invalid Arg] - format is not set");
+        if (((uint32_t)desc.flags & (uint32_t)ommCpuTextureFlags_EnableCutoffDistance) && desc.alphaCutoff < 0.f)
+            return m_log.InvalidArg("[Invalid Arg] - EnableCutoffDistance requires alphaCutoff to be set");
+        const bool referenceData = (uint32_t)desc.flags & (uint32_t)ommCpuTextureFlags_ReferenceTextureData;
+        if (referenceData && !((uint32_t)desc.flags & (uint32_t)ommCpuTextureFlags_DisableZOrder))
+            return m_log.InvalidArg("[Invalid Arg] - ReferenceTextureData requires DisableZOrder to be set");
 
         for (uint32_t i = 0; i < desc.mipCount; ++i)
         {
@@ -59,21 +126,19 @@ namespace omm
                 return m_log.InvalidArg("[Invalid Arg] - mips.width must be less than kMaxDim.x (65536)");
             if (desc.mips[i].height > kMaxDim.y)
                 return m_log.InvalidArg("[Invalid Arg] - mips.height must be less than kMaxDim.y (65536)");
+            if (referenceData)
+            {
+                const size_t sizePerPixel = GetSizePerPixel(desc.format);
+                if ((uintptr_t)desc.mips[i].textureData % sizePerPixel != 0)
+                    return m_log.InvalidArg("[Invalid Arg] - mips.textureData must be aligned to the texel size when ReferenceTextureData is set");
+                if (desc.mips[i].rowPitch != 0 && (desc.mips[i].rowPitch % sizePerPixel != 0 || desc.mips[i].rowPitch < desc.mips[i].width * sizePerPixel))
+                    return m_log.InvalidArg("[Invalid Arg] - mips.rowPitch must be a multiple of the texel size and hold a full row when ReferenceTextureData is set");
+            }
         }
 
         return ommResult_SUCCESS;
     }
 
-    static size_t GetSizePerPixel(ommCpuTextureFormat format)
-    {
-        if (format == ommCpuTextureFormat_UNORM8)
-            return sizeof(uint8_t);
-        else if (format == ommCpuTextureFormat_FP32)
-            return sizeof(float);
-        OMM_ASSERT(false);
-        return 0;
-    }
-
     ommResult TextureImpl::Create(const ommCpuTextureDesc& desc)
     {
         RETURN_STATUS_IF_FAILED(Validate(desc));
@@ -82,16 +147,21 @@ namespace omm
 
         m_mips.resize(desc.mipCount);
         m_tilingMode = !!((uint32_t)desc.flags & (uint32_t)ommCpuTextureFlags_DisableZOrder) ? TilingMode::Linear : TilingMode::MortonZ;
+
+        // Morton order pads every mip to a power of two square, tile the texture instead when that would waste memory.
+        for (uint32_t mipIt = 0; mipIt < desc.mipCount && m_tilingMode == TilingMode::MortonZ; ++mipIt)
+        {
+            if (desc.mips[mipIt].width != desc.mips[mipIt].height || !omm::isPow2(desc.mips[mipIt].width))
+                m_tilingMode = TilingMode::BlockLinear;
+        }
         m_textureFormat = desc.format;
         m_alphaCutoff = desc.alphaCutoff;
         m_textureFlags = desc.flags;
 
         const size_t sizePerPixel = GetSizePerPixel(m_textureFormat);
-
-        const bool enableSAT = std::numeric_limits<uint32_t>::max() > m_mips[0].numElements && m_alphaCutoff >= 0;
+        const bool referenceData = (uint32_t)desc.flags & (uint32_t)ommCpuTextureFlags_ReferenceTextureData;
 
         m_dataSize = 0;
-        m_dataSATSize = 0;
         for (uint32_t mipIt = 0; mipIt < desc.mipCount; ++mipIt)
         {
             m_mips[mipIt].size = { desc.mips[mipIt].width, desc.mips[mipIt].height };
@@ -102,19 +172,24 @@ namespace omm
             m_mips[mipIt].rcpSize = 1.f / (float2)m_mips[mipIt].size;
             m_mips[mipIt].sizeIsPow2 = omm::isPow2(m_mips[mipIt].size.x) && omm::isPow2(m_mips[mipIt].size.y);
             m_mips[mipIt].dataOffset = m_dataSize;
-            m_mips[mipIt].dataOffsetSAT = m_dataSATSize;
 
             if (m_tilingMode == TilingMode::Linear)
             {
-              //  m_mips[mipIt].rowPitch = sizePerPixel * size_t(m_mips[mipIt].size.x);
+                m_mips[mipIt].rowPitch = m_mips[mipIt].size.x;
                 m_mips[mipIt].numElements = size_t(m_mips[mipIt].size.x) * m_mips[mipIt].size.y;
             }
             else if (m_tilingMode == TilingMode::MortonZ)
             {
                 size_t maxDim = nextPow2(std::max(m_mips[mipIt].size.x, m_mips[mipIt].size.y));
-             //   m_mips[mipIt].rowPitch = sizePerPixel * maxDim;
+                m_mips[mipIt].rowPitch = 0;
                 m_mips[mipIt].numElements = maxDim * maxDim;
             }
+            else if (m_tilingMode == TilingMode::BlockLinear)
+            {
+                const int2 numTiles = (m_mips[mipIt].size + int2((1 << kBlockLinearTileSizeLog2) - 1)) >> kBlockLinearTileSizeLog2;
+                m_mips[mipIt].rowPitch = 0;
+                m_mips[mipIt].numElements = (size_t(numTiles.x) * numTiles.y) << (2 * kBlockLinearTileSizeLog2);
+            }
             else
             {
                 OMM_ASSERT(false);
@@ -123,19 +198,33 @@ namespace omm
 
             m_dataSize += sizePerPixel * m_mips[mipIt].numElements;
             m_dataSize = math::Align(m_dataSize, kAlignment);
+        }
 
-            if (enableSAT)
+        if (referenceData)
+        {
+            // The offsets above still describe the layout the texture is serialized in.
+            for (uint32_t mipIt = 0; mipIt < desc.mipCount; ++mipIt)
             {
-                m_dataSATSize += sizeof(uint32_t) * m_mips[mipIt].numElements;;
-                m_dataSATSize = math::Align(m_dataSATSize, kAlignment);
+                Mips& mip = m_mips[mipIt];
+                if (desc.mips[mipIt].rowPitch != 0)
+                    mip.rowPitch = desc.mips[mipIt].rowPitch / sizePerPixel;
+                mip.numElements = mip.rowPitch * (mip.size.y - 1) + mip.size.x;
+                mip.data = (const uint8_t*)desc.mips[mipIt].textureData;
             }
+
+            BuildSAT();
+            BuildAlphaRange();
+            BuildCutoffDistance();
+
+            return ommResult_SUCCESS;
         }
 
         m_data = m_stdAllocator.allocate(m_dataSize, kAlignment);
-        m_dataSAT = enableSAT ? m_stdAllocator.allocate(m_dataSATSize, kAlignment) : nullptr;
 
         for (uint32_t mipIt = 0; mipIt < desc.mipCount; ++mipIt)
         {
+            m_mips[mipIt].data = m_data + m_mips[mipIt].dataOffset;
+
             if (m_tilingMode == TilingMode::Linear)
             {
                 const size_t kDefaultRowPitch = sizePerPixel * desc.mips[mipIt].width;
@@ -161,66 +250,366 @@ namespace omm
                     }
                 }
             }
-            else if (m_tilingMode == TilingMode::MortonZ)
+            else if (m_tilingMode == TilingMode::MortonZ || m_tilingMode == TilingMode::BlockLinear)
             {
                 uint8_t* dst = (uint8_t*)(m_data + m_mips[mipIt].dataOffset);
                 const uint8_t* src = (uint8_t*)(desc.mips[mipIt].textureData);
 
                 const size_t rowPitch = desc.mips[mipIt].rowPitch == 0 ? desc.mips[mipIt].width : desc.mips[mipIt].rowPitch;
+                const int2 size = m_mips[mipIt].size;
+                const bool enableInternalThreads = UseInternalThreads();
+
+                if (m_tilingMode == TilingMode::MortonZ && sizePerPixel == sizeof(float))
+                    CopyToTiled<TilingMode::MortonZ, sizeof(float)>(dst, src, size, rowPitch * sizePerPixel, enableInternalThreads);
+                else if (m_tilingMode == TilingMode::MortonZ)
+                    CopyToTiled<TilingMode::MortonZ, sizeof(uint8_t)>(dst, src, size, rowPitch * sizePerPixel, enableInternalThreads);
+                else if (sizePerPixel == sizeof(float))
+                    CopyToTiled<TilingMode::BlockLinear, sizeof(float)>(dst, src, size, rowPitch * sizePerPixel, enableInternalThreads);
+                else
+                    CopyToTiled<TilingMode::BlockLinear, sizeof(uint8_t)>(dst, src, size, rowPitch * sizePerPixel, enableInternalThreads);
+            }
+            else
+            {
+                OMM_ASSERT(false);
+                return ommResult_FAILURE;
+            }
+        }
+
+        BuildSAT();
+        BuildAlphaRange();
+        BuildCutoffDistance();
+
+        return ommResult_SUCCESS;
+    }
+
+    void TextureImpl::BuildAlphaRange()
+    {
+        OMM_ASSERT(m_dataAlphaRange == nullptr);
 
-                for (int j = 0; j < m_mips[mipIt].size.y; ++j)
+        size_t numEntries = 0;
+        for (Mips& mip : m_mips)
+        {
+            int2 levelSize = (mip.size + int2((1 << kAlphaRangeBlockSizeLog2) - 1)) >> kAlphaRangeBlockSizeLog2;
+            mip.numAlphaRangeLevels = 0;
+            while (true)
+            {
+                OMM_ASSERT(mip.numAlphaRangeLevels < kMaxAlphaRangeLevels);
+                mip.alphaRangeLevelSize[mip.numAlphaRangeLevels] = levelSize;
+                mip.alphaRangeLevelOffset[mip.numAlphaRangeLevels] = numEntries;
+                mip.numAlphaRangeLevels++;
+                numEntries += size_t(levelSize.x) * levelSize.y;
+
+                if (levelSize.x == 1 && levelSize.y == 1)
+                    break;
+                levelSize = (levelSize + 1) >> 1;
+            }
+        }
+
+        const size_t entrySize = m_textureFormat == ommCpuTextureFormat_UNORM8 ? sizeof(AlphaRange<ommCpuTextureFormat_UNORM8>) : sizeof(AlphaRange<ommCpuTextureFormat_FP32>);
+        m_dataAlphaRange = m_stdAllocator.allocate(entrySize * numEntries, kAlignment);
+
+        const bool enableInternalThreads = UseInternalThreads();
+        DispatchTexelLayout(m_textureFormat, m_tilingMode, [&]<ommCpuTextureFormat eFormat, TilingMode eTilingMode>() {
+            using Range = AlphaRange<eFormat>;
+            using Alpha = typename Range::value_type;
+            Range* alphaRange = (Range*)m_dataAlphaRange;
+
+            for (uint32_t mipIt = 0; mipIt < m_mips.size(); ++mipIt)
+            {
+                const Mips& mip = m_mips[mipIt];
+
+                // Finest level from the texels, every level row is written by one iteration.
                 {
-                    for (int i = 0; i < m_mips[mipIt].size.x; ++i)
+                    Range* level = alphaRange + mip.alphaRangeLevelOffset[0];
+                    const int2 levelSize = mip.alphaRangeLevelSize[0];
+
+                    #pragma omp parallel for if(enableInternalThreads)
+                    for (int32_t levelY = 0; levelY < levelSize.y; ++levelY)
                     {
-                        const uint64_t idx = From2Dto1D<TilingMode::MortonZ>(int2(i, j), m_mips[mipIt].size);
-                        OMM_ASSERT(idx < m_mips[mipIt].numElements);
+                        Range* row = level + levelY * levelSize.x;
+                        for (int32_t i = 0; i < levelSize.x; ++i)
+                            row[i] = Range(std::numeric_limits<Alpha>::max(), std::numeric_limits<Alpha>::lowest());
+
+                        const int32_t jEnd = std::min((levelY + 1) << kAlphaRangeBlockSizeLog2, mip.size.y);
+                        for (int32_t j = levelY << kAlphaRangeBlockSizeLog2; j < jEnd; ++j)
+                        {
+                            for (int32_t i = 0; i < mip.size.x; ++i)
+                            {
+                                // UNORM8 texels load as n / 255, rounding recovers n exactly.
+                                const float texel = Load<eFormat, eTilingMode>(int2(i, j), mipIt);
+                                const Alpha alpha = eFormat == ommCpuTextureFormat_UNORM8 ? (Alpha)(texel * 255.f + 0.5f) : (Alpha)texel;
+                                Range& r = row[i >> kAlphaRangeBlockSizeLog2];
+                                r.x = std::min(r.x, alpha);
+                                r.y = std::max(r.y, alpha);
+                            }
+                        }
+                    }
+                }
 
-                        uint8_t* cpyDst         = dst + idx * sizePerPixel;
-                        const uint8_t* cpySrc   = src + (i + j * rowPitch) * sizePerPixel;
+                // Each coarser entry covers 2x2 entries of the level below, clamped at the edge of odd sized grids.
+                for (uint32_t levelIt = 1; levelIt < mip.numAlphaRangeLevels; ++levelIt)
+                {
+                    const Range* src = alphaRange + mip.alphaRangeLevelOffset[levelIt - 1];
+                    const int2 srcSize = mip.alphaRangeLevelSize[levelIt - 1];
+                    Range* dst = alphaRange + mip.alphaRangeLevelOffset[levelIt];
+                    const int2 dstSize = mip.alphaRangeLevelSize[levelIt];
 
-                        memcpy(cpyDst, cpySrc, sizePerPixel);
+                    #pragma omp parallel for if(enableInternalThreads)
+                    for (int j = 0; j < dstSize.y; ++j)
+                    {
+                        const int j0 = 2 * j;
+                        const int j1 = std::min(2 * j + 1, srcSize.y - 1);
+                        for (int i = 0; i < dstSize.x; ++i)
+                        {
+                            const int i0 = 2 * i;
+                            const int i1 = std::min(2 * i + 1, srcSize.x - 1);
+                            const Range a = src[i0 + j0 * srcSize.x];
+                            const Range b = src[i1 + j0 * srcSize.x];
+                            const Range c = src[i0 + j1 * srcSize.x];
+                            const Range d = src[i1 + j1 * srcSize.x];
+                            dst[i + j * dstSize.x] = Range(
+                                std::min(std::min(a.x, b.x), std::min(c.x, d.x)),
+                                std::max(std::max(a.y, b.y), std::max(c.y, d.y)));
+                        }
                     }
                 }
             }
-            else
+        });
+    }
+
+    void TextureImpl::BuildSAT()
+    {
+        OMM_ASSERT(m_dataSAT == nullptr);
+
+        // Counts are 32-bit, a texture with more texels than that gets no SAT.
+        const bool enableSAT = HasAlphaCutoff() && uint64_t(m_mips[0].size.x) * m_mips[0].size.y < std::numeric_limits<uint32_t>::max();
+        if (!enableSAT)
+            return;
+
+        AllocateSAT();
+
+        const bool enableInternalThreads = UseInternalThreads();
+        for (uint32_t mipIt = 0; mipIt < m_mips.size(); ++mipIt)
+        {
+            // Every block row of opacity bits is written by one iteration.
+            DispatchTexelLayout(m_textureFormat, m_tilingMode, [&]<ommCpuTextureFormat eFormat, TilingMode eTilingMode>() {
+                const Mips& mip = m_mips[mipIt];
+                uint64_t* masks = (uint64_t*)(m_dataSAT + mip.satMaskOffset);
+
+                #pragma omp parallel for if(enableInternalThreads)
+                for (int32_t by = 0; by < mip.satNumBlocks.y; ++by)
+                {
+                    const int32_t y0 = by << kSATBlockSizeLog2;
+                    const int32_t y1 = std::min(y0 + kOpacityBlockSize, mip.size.y);
+                    for (int32_t bx = 0; bx < mip.satNumBlocks.x; ++bx)
+                    {
+                        const int32_t x0 = bx << kSATBlockSizeLog2;
+                        const int32_t x1 = std::min(x0 + kOpacityBlockSize, mip.size.x);
+                        uint64_t mask = 0;
+                        for (int32_t y = y0; y < y1; ++y)
+                        {
+                            for (int32_t x = x0; x < x1; ++x)
+                            {
+                                if (Load<eFormat, eTilingMode>(int2(x, y), mipIt) > m_alphaCutoff)
+                                    mask |= 1ull << (((y - y0) << kSATBlockSizeLog2) + (x - x0));
+                            }
+                        }
+                        masks[bx + by * size_t(mip.satNumBlocks.x)] = mask;
+                    }
+                }
+            });
+        }
+
+        BuildSATCounts();
+    }
+
+    void TextureImpl::AllocateSAT()
+    {
+        OMM_ASSERT(m_dataSAT == nullptr);
+
+        m_dataSATSize = 0;
+        auto reserve = [this](size_t size) {
+            const size_t offset = m_dataSATSize;
+            m_dataSATSize = math::Align(m_dataSATSize + size, kAlignment);
+            return offset;
+        };
+
+        for (Mips& mip : m_mips)
+        {
+            mip.satNumBlocks = (mip.size + int2(kSATBlockMask)) >> kSATBlockSizeLog2;
+            const size_t numBlocks = size_t(mip.satNumBlocks.x) * mip.satNumBlocks.y;
+            const size_t numSuperBlocksX = ((size_t)mip.size.x + (1 << kSATSuperBlockSizeLog2) - 1) >> kSATSuperBlockSizeLog2;
+            const size_t numSuperBlocksY = ((size_t)mip.size.y + (1 << kSATSuperBlockSizeLog2) - 1) >> kSATSuperBlockSizeLog2;
+
+            mip.satMaskOffset = reserve(sizeof(uint64_t) * numBlocks);
+            mip.satCornerOffset = reserve(sizeof(uint32_t) * numBlocks);
+            mip.satTopOffset = reserve(sizeof(uint16_t) * mip.satNumBlocks.y * size_t(mip.size.x));
+            mip.satTopBaseOffset = reserve(sizeof(uint32_t) * numSuperBlocksY * mip.size.x);
+            mip.satLeftOffset = reserve(sizeof(uint16_t) * mip.satNumBlocks.x * size_t(mip.size.y));
+            mip.satLeftBaseOffset = reserve(sizeof(uint32_t) * numSuperBlocksX * mip.size.y);
+        }
+
+        m_dataSAT = m_stdAllocator.allocate(m_dataSATSize, kAlignment);
+        std::memset(m_dataSAT, 0, m_dataSATSize);
+    }
+
+    void TextureImpl::BuildSATCounts()
+    {
+        static constexpr int32_t kBlocksPerSuperBlockLog2 = kSATSuperBlockSizeLog2 - kSATBlockSizeLog2;
+        static constexpr int32_t kBlocksPerSuperBlockMask = (1 << kBlocksPerSuperBlockLog2) - 1;
+
+        const bool enableInternalThreads = UseInternalThreads();
+        for (const Mips& mip : m_mips)
+        {
+            const int2 numBlocks = mip.satNumBlocks;
+            const int32_t w = mip.size.x;
+            const int32_t h = mip.size.y;
+            const uint64_t* masks = (const uint64_t*)(m_dataSAT + mip.satMaskOffset);
+            uint32_t* corner = (uint32_t*)(m_dataSAT + mip.satCornerOffset);
+            uint16_t* top = (uint16_t*)(m_dataSAT + mip.satTopOffset);
+            uint32_t* topBase = (uint32_t*)(m_dataSAT + mip.satTopBaseOffset);
+            uint16_t* left = (uint16_t*)(m_dataSAT + mip.satLeftOffset);
+            uint32_t* leftBase = (uint32_t*)(m_dataSAT + mip.satLeftBaseOffset);
+
+            // Blocks above-left: the popcount prefix of the block row above, per block row in parallel, then accumulated
+            // down the columns.
+            #pragma omp parallel for if(enableInternalThreads)
+            for (int32_t by = 1; by < numBlocks.y; ++by)
             {
-                OMM_ASSERT(false);
-                return ommResult_FAILURE;
+                uint32_t rowSum = 0;
+                for (int32_t bx = 0; bx < numBlocks.x; ++bx)
+                {
+                    corner[bx + by * size_t(numBlocks.x)] = rowSum;
+                    rowSum += (uint32_t)std::popcount(masks[bx + (by - 1) * size_t(numBlocks.x)]);
+                }
             }
 
-            if (enableSAT)
+            for (int32_t by = 2; by < numBlocks.y; ++by)
             {
-                uint32_t* dataSAT = (uint32_t * )(m_dataSAT + m_mips[mipIt].dataOffsetSAT);
+                for (int32_t bx = 0; bx < numBlocks.x; ++bx)
+                    corner[bx + by * size_t(numBlocks.x)] += corner[bx + (by - 1) * size_t(numBlocks.x)];
+            }
 
-                for (int j = 0; j < m_mips[mipIt].size.y; ++j)
+            // Columns [bx * 8, x] of the block rows above, accumulated down the column. One block column per iteration.
+            #pragma omp parallel for if(enableInternalThreads)
+            for (int32_t bx = 0; bx < numBlocks.x; ++bx)
+            {
+                const int32_t x0 = bx << kSATBlockSizeLog2;
+                const int32_t x1 = std::min(x0 + kOpacityBlockSize, w);
+                uint32_t sum[kOpacityBlockSize] = {};
+                for (int32_t by = 0; by < numBlocks.y; ++by)
                 {
-                    for (int i = 0; i < m_mips[mipIt].size.x; ++i)
+                    const uint64_t mask = by > 0 ? masks[bx + (by - 1) * size_t(numBlocks.x)] : 0ull;
+                    for (int32_t x = x0; x < x1; ++x)
                     {
-                        dataSAT[i + j * m_mips[mipIt].size.x] = Load(int2(i, j), mipIt) > m_alphaCutoff;
+                        sum[x - x0] += (uint32_t)std::popcount(mask & GetSATColumnMask(x - x0));
+                        uint32_t& base = topBase[x + size_t(by >> kBlocksPerSuperBlockLog2) * w];
+                        if ((by & kBlocksPerSuperBlockMask) == 0)
+                            base = sum[x - x0];
+                        top[x + size_t(by) * w] = (uint16_t)(sum[x - x0] - base);
                     }
                 }
+            }
 
-                // sum in X
-                for (int j = 0; j < m_mips[mipIt].size.y; ++j)
+            // Rows [by * 8, y] of the block columns to the left, accumulated along the row. One block row per iteration.
+            #pragma omp parallel for if(enableInternalThreads)
+            for (int32_t by = 0; by < numBlocks.y; ++by)
+            {
+                const int32_t y0 = by << kSATBlockSizeLog2;
+                const int32_t y1 = std::min(y0 + kOpacityBlockSize, h);
+                uint32_t sum[kOpacityBlockSize] = {};
+                for (int32_t bx = 0; bx < numBlocks.x; ++bx)
                 {
-                    for (int i = 1; i < m_mips[mipIt].size.x; ++i)
+                    const uint64_t mask = bx > 0 ? masks[(bx - 1) + by * size_t(numBlocks.x)] : 0ull;
+                    for (int32_t y = y0; y < y1; ++y)
                     {
-                        dataSAT[i + j * m_mips[mipIt].size.x] += dataSAT[i - 1 + j * m_mips[mipIt].size.x];
+                        sum[y - y0] += (uint32_t)std::popcount(mask & GetSATRowMask(y - y0));
+                        uint32_t& base = leftBase[y + size_t(bx >> kBlocksPerSuperBlockLog2) * h];
+                        if ((bx & kBlocksPerSuperBlockMask) == 0)
+                            base = sum[y - y0];
+                        left[y + size_t(bx) * h] = (uint16_t)(sum[y - y0] - base);
                     }
                 }
+            }
+        }
+    }
+
+    void TextureImpl::BuildCutoffDistance()
+    {
+        OMM_ASSERT(m_dataCutoffDistance == nullptr);
+
+        // The distances are taken on the opacity bits of the SAT.
+        if (!((uint32_t)m_textureFlags & (uint32_t)ommCpuTextureFlags_EnableCutoffDistance) || !HasSAT())
+            return;
+
+        size_t numTexels = 0;
+        for (Mips& mip : m_mips)
+        {
+            mip.cutoffDistanceOffset = numTexels;
+            numTexels += size_t(mip.size.x) * mip.size.y;
+        }
 
-                // sum in Y
-                for (int j = 1; j < m_mips[mipIt].size.y; ++j)
+        m_dataCutoffDistance = m_stdAllocator.allocate(numTexels, kAlignment);
+
+        for (uint32_t mipIt = 0; mipIt < m_mips.size(); ++mipIt)
+        {
+            const Mips& mip = m_mips[mipIt];
+            const int32_t w = mip.size.x;
+            const int32_t h = mip.size.y;
+            uint8_t* dist = m_dataCutoffDistance + mip.cutoffDistanceOffset;
+
+            // Texels with a neighbour on the other side are one texel away from it. Any other texel is d + 1 away, where
+            // d is the distance to the closest of these on either side, so a two pass chamfer transform with unit
+            // weights on the eight neighbours gives the exact Chebyshev distance. Only the seeding is parallel.
+            #pragma omp parallel for if(UseInternalThreads())
+            for (int32_t y = 0; y < h; ++y)
+            {
+                for (int32_t x = 0; x < w; ++x)
                 {
-                    for (int i = 0; i < m_mips[mipIt].size.x; ++i)
+                    const bool isAbove = IsAboveAlphaCutoff(int2(x, y), mipIt);
+                    bool hasOtherSide = false;
+                    for (int32_t j = std::max(y - 1, 0); j <= std::min(y + 1, h - 1); ++j)
                     {
-                        dataSAT[i + j * m_mips[mipIt].size.x] += dataSAT[i + (j - 1) * m_mips[mipIt].size.x];
+                        for (int32_t i = std::max(x - 1, 0); i <= std::min(x + 1, w - 1); ++i)
+                            hasOtherSide |= IsAboveAlphaCutoff(int2(i, j), mipIt) != isAbove;
                     }
+                    dist[x + y * size_t(w)] = hasOtherSide ? 1 : kMaxCutoffDistance;
                 }
             }
-        }
 
-        return ommResult_SUCCESS;
+            auto Relax = [dist, w](int32_t x, int32_t y, int32_t nx, int32_t ny) {
+                uint8_t& d = dist[x + y * size_t(w)];
+                d = (uint8_t)std::min<uint32_t>(d, std::min<uint32_t>(dist[nx + ny * size_t(w)] + 1u, kMaxCutoffDistance));
+            };
+
+            for (int32_t y = 0; y < h; ++y)
+            {
+                for (int32_t x = 0; x < w; ++x)
+                {
+                    if (x > 0)
+                        Relax(x, y, x - 1, y);
+                    if (y > 0)
+                    {
+                        for (int32_t i = std::max(x - 1, 0); i <= std::min(x + 1, w - 1); ++i)
+                            Relax(x, y, i, y - 1);
+                    }
+                }
+            }
+
+            for (int32_t y = h - 1; y >= 0; --y)
+            {
+                for (int32_t x = w - 1; x >= 0; --x)
+                {
+                    if (x < w - 1)
+                        Relax(x, y, x + 1, y);
+                    if (y < h - 1)
+                    {
+                        for (int32_t i = std::max(x - 1, 0); i <= std::min(x + 1, w - 1); ++i)
+                            Relax(x, y, i, y + 1);
+                    }
+                }
+            }
+        }
     }
 
     void TextureImpl::Deallocate()
@@ -234,6 +623,17 @@ namespace omm
         {
             m_stdAllocator.deallocate((uint8_t*)m_dataSAT, 0);
             m_dataSAT = nullptr;
+            m_dataSATSize = 0;
+        }
+        if (m_dataAlphaRange != nullptr)
+        {
+            m_stdAllocator.deallocate(m_dataAlphaRange, 0);
+            m_dataAlphaRange = nullptr;
+        }
+        if (m_dataCutoffDistance != nullptr)
+        {
+            m_stdAllocator.deallocate(m_dataCutoffDistance, 0);
+            m_dataCutoffDistance = nullptr;
         }
         m_mips.clear();
     }
@@ -246,6 +646,8 @@ namespace omm
                 return Load<ommCpuTextureFormat_FP32, TilingMode::Linear>(texCoord, mip);
             else if (m_tilingMode == TilingMode::MortonZ)
                 return Load<ommCpuTextureFormat_FP32, TilingMode::MortonZ>(texCoord, mip);
+            else if (m_tilingMode == TilingMode::BlockLinear)
+                return Load<ommCpuTextureFormat_FP32, TilingMode::BlockLinear>(texCoord, mip);
         }
         else if (m_textureFormat == ommCpuTextureFormat_UNORM8)
         {
@@ -253,6 +655,8 @@ namespace omm
                 return Load<ommCpuTextureFormat_UNORM8, TilingMode::Linear>(texCoord, mip);
             else if (m_tilingMode == TilingMode::MortonZ)
                 return Load<ommCpuTextureFormat_UNORM8, TilingMode::MortonZ>(texCoord, mip);
+            else if (m_tilingMode == TilingMode::BlockLinear)
+                return Load<ommCpuTextureFormat_UNORM8, TilingMode::BlockLinear>(texCoord, mip);
         }
         OMM_ASSERT(false);
         return 0.f;
@@ -280,7 +684,8 @@ namespace omm
     ommResult TextureImpl::GetTextureDesc(ommCpuTextureDesc& desc) const
     {
         desc.format = m_textureFormat;
-        desc.flags = m_textureFlags;
+        // The exported texels are written to the caller's buffers, a desc passed back must copy them.
+        desc.flags = (ommCpuTextureFlags)((uint32_t)m_textureFlags & ~(uint32_t)ommCpuTextureFlags_ReferenceTextureData);
         desc.alphaCutoff = m_alphaCutoff;
         desc.mipCount = (uint32_t)m_mips.size();
 
@@ -297,27 +702,35 @@ namespace omm
             {
                 const size_t sizePerPixel = GetSizePerPixel(m_textureFormat);
 
-                if (m_tilingMode == TilingMode::MortonZ)
+                if (m_tilingMode == TilingMode::MortonZ || m_tilingMode == TilingMode::BlockLinear)
                 {
-                    const uint8_t* src = (uint8_t*)(m_data + m_mips[mipIt].dataOffset);
+                    const uint8_t* src = m_mips[mipIt].data;
                     uint8_t* dst = (uint8_t*)(desc.mips[mipIt].textureData);
 
-                    for (int i = 0; i < m_mips[mipIt].numElements; ++i)
+                    // Only the texels inside the mip, the padding of the tiled layout has no place in dst.
+                    for (int j = 0; j < m_mips[mipIt].size.y; ++j)
                     {
-                        const int2 pos = From1Dto2D<TilingMode::MortonZ>(i, m_mips[mipIt].size);
+                        for (int i = 0; i < m_mips[mipIt].size.x; ++i)
+                        {
+                            const uint32_t idx = m_tilingMode == TilingMode::MortonZ ?
+                                From2Dto1D<TilingMode::MortonZ>(int2(i, j), m_mips[mipIt].size) :
+                                From2Dto1D<TilingMode::BlockLinear>(int2(i, j), m_mips[mipIt].size);
 
-                        const uint8_t* cpySrc = src + i * sizePerPixel;
-                        uint8_t* cpyDst = dst + (pos.x + pos.y * desc.mips[mipIt].rowPitch) * sizePerPixel;
+                            const uint8_t* cpySrc = src + size_t(idx) * sizePerPixel;
+                            uint8_t* cpyDst = dst + (i + j * size_t(mip.rowPitch)) * sizePerPixel;
 
-                        memcpy(cpyDst, cpySrc, sizePerPixel);
+                            memcpy(cpyDst, cpySrc, sizePerPixel);
+                        }
                     }
                 }
                 else // if (m_tilingMode == TilingMode::Linear)
                 {
-                    const uint8_t* src = (uint8_t*)(m_data + m_mips[mipIt].dataOffset);
+                    const uint8_t* src = m_mips[mipIt].data;
                     uint8_t* dst = (uint8_t*)(desc.mips[mipIt].textureData);
-                    size_t numTexels = mip.width * mip.height;
-                    memcpy(dst, src, numTexels * sizePerPixel);
+                    const size_t dstRowPitch = mip.width * sizePerPixel;
+                    const size_t srcRowPitch = m_mips[mipIt].rowPitch * sizePerPixel;
+                    for (uint32_t rowIt = 0; rowIt < mip.height; ++rowIt)
+                        memcpy(dst + rowIt * dstRowPitch, src + rowIt * srcRowPitch, dstRowPitch);
                 }
             }
         }
@@ -342,6 +755,15 @@ namespace omm
         return xy_to_morton(idx.x, idx.y);
     }
 
+    template<>
+    uint32_t TextureImpl::From2Dto1D<TilingMode::BlockLinear>(const int2& idx, const int2& size)
+    {
+        const uint32_t numTilesX = (uint32_t(size.x) + (1u << kBlockLinearTileSizeLog2) - 1) >> kBlockLinearTileSizeLog2;
+        const uint32_t tile = (uint32_t(idx.y) >> kBlockLinearTileSizeLog2) * numTilesX + (uint32_t(idx.x) >> kBlockLinearTileSizeLog2);
+        const uint32_t tileMask = (1u << kBlockLinearTileSizeLog2) - 1;
+        return (tile << (2 * kBlockLinearTileSizeLog2)) | xy_to_morton(idx.x & tileMask, idx.y & tileMask);
+    }
+
     template<> uint2 TextureImpl::From1Dto2D<TilingMode::Linear>(const uint32_t idx, const int2& size)
     {
         uint2 pos;
@@ -21,11 +21,16 @@ license agreement from NVIDIA CORPORATION is strictly prohibited.
 #include "util/bit_tricks.h"
 #include "util/texture.h"
 
+#include <bit>
+#include <type_traits>
+
 namespace omm
 {
     enum class TilingMode {
         Linear,
         MortonZ,
+        // Row-major 8x8 tiles in Morton order, padded to whole tiles instead of a power of two square.
+        BlockLinear,
         MAX_NUM,
     };
 
@@ -102,28 +107,118 @@ namespace omm
                 texCoord.y < m_mips[mip].size.y;
         }
 
+        // The SAT is built when the alpha cutoff is embedded, its opacity bits double as a 1-bit mask of the texture.
         bool HasSAT() const
         {
             return m_dataSAT != nullptr;
         }
 
+        // Texels are grouped in kOpacityBlockSize^2 blocks aligned to multiples of kOpacityBlockSize.
+        static constexpr int32_t kOpacityBlockSize = 8;
+
+        bool IsAboveAlphaCutoff(int2 texCoord, int32_t mip) const
+        {
+            OMM_ASSERT(HasSAT());
+            OMM_ASSERT(InTexture(texCoord, mip));
+            const Mips& m = m_mips[mip];
+            const uint64_t mask = ((const uint64_t*)(m_dataSAT + m.satMaskOffset))[(texCoord.x >> kSATBlockSizeLog2) + (texCoord.y >> kSATBlockSizeLog2) * size_t(m.satNumBlocks.x)];
+            return (mask >> (((texCoord.y & kSATBlockMask) << kSATBlockSizeLog2) + (texCoord.x & kSATBlockMask))) & 1ull;
+        }
+
+        // Opacity bits of the block at blockMin, bit (y * kOpacityBlockSize + x) is set when texel blockMin + (x, y) is
+        // above the alpha cutoff. Texels outside of the texture read as zero.
+        uint64_t GetAlphaCutoffBlock(int2 blockMin, int32_t mip) const
+        {
+            OMM_ASSERT(HasSAT());
+            OMM_ASSERT(InTexture(blockMin, mip));
+            OMM_ASSERT((blockMin.x & kSATBlockMask) == 0 && (blockMin.y & kSATBlockMask) == 0);
+            const Mips& m = m_mips[mip];
+            return ((const uint64_t*)(m_dataSAT + m.satMaskOffset))[(blockMin.x >> kSATBlockSizeLog2) + (blockMin.y >> kSATBlockSizeLog2) * size_t(m.satNumBlocks.x)];
+        }
+
+        // Number of texels above the alpha cutoff in [s, e].
         uint32_t SAT(int2 s, int2 e, int32_t mip) const
         {
             OMM_ASSERT(InTexture(s, mip));
             OMM_ASSERT(InTexture(e, mip));
-            uint32_t* dataSAT = (uint32_t*)(m_dataSAT + m_mips[mip].dataOffsetSAT);
 
             int32_t s_x_minus_one = (s.x - 1);
             int32_t s_y_minus_one = (s.y - 1);
 
-            const uint32_t A = s_x_minus_one >= 0 && s_y_minus_one >= 0 ? dataSAT[(s_x_minus_one) + (s_y_minus_one) * m_mips[mip].size.x] : 0;
-            const uint32_t B = s_y_minus_one >= 0 ? dataSAT[e.x + (s_y_minus_one) * m_mips[mip].size.x] : 0;
-            const uint32_t C = s_x_minus_one >= 0 ? dataSAT[(s_x_minus_one) + (e.y) * m_mips[mip].size.x] : 0;
-            const uint32_t D = dataSAT[e.x + (e.y) * m_mips[mip].size.x];
+            const uint32_t A = s_x_minus_one >= 0 && s_y_minus_one >= 0 ? SATPrefix(s_x_minus_one, s_y_minus_one, mip) : 0;
+            const uint32_t B = s_y_minus_one >= 0 ? SATPrefix(e.x, s_y_minus_one, mip) : 0;
+            const uint32_t C = s_x_minus_one >= 0 ? SATPrefix(s_x_minus_one, e.y, mip) : 0;
+            const uint32_t D = SATPrefix(e.x, e.y, mip);
             int32_t sum = D + A - B - C;
             return sum;
         }
 
+        bool HasCutoffDistance() const
+        {
+            return m_dataCutoffDistance != nullptr;
+        }
+
+        static constexpr uint32_t kMaxCutoffDistance = 255;
+
+        // Chebyshev distance in texels from texCoord to the nearest texel on the other side of the alpha cutoff, saturated at
+        // kMaxCutoffDistance. Every texel closer than that is on the same side as texCoord.
+        uint32_t GetCutoffDistance(int2 texCoord, int32_t mip) const
+        {
+            OMM_ASSERT(InTexture(texCoord, mip));
+            const Mips& m = m_mips[mip];
+            return m_dataCutoffDistance[m.cutoffDistanceOffset + texCoord.x + texCoord.y * size_t(m.size.x)];
+        }
+
+        bool HasAlphaRange() const
+        {
+            return m_dataAlphaRange != nullptr;
+        }
+
+        // Entries of the min/max pyramid keep the texel format, min (x) and max (y) of the texels they cover.
+        template<ommCpuTextureFormat eFormat>
+        using AlphaRange = std::conditional_t<eFormat == ommCpuTextureFormat_UNORM8, uchar2, float2>;
+
+        // Min (x) and max (y) alpha of the texels in [s, e]. Walks up the pyramid until the region spans at most 2x2
+        // blocks, the range is conservative and may include texels around the region.
+        template<ommCpuTextureFormat eFormat>
+        float2 GetAlphaRange(int2 s, int2 e, int32_t mip) const
+        {
+            OMM_ASSERT(eFormat == m_textureFormat);
+            OMM_ASSERT(InTexture(s, mip));
+            OMM_ASSERT(InTexture(e, mip));
+            const Mips& m = m_mips[mip];
+
+            int2 bs = s >> kAlphaRangeBlockSizeLog2;
+            int2 be = e >> kAlphaRangeBlockSizeLog2;
+            uint32_t level = 0;
+            while (be.x - bs.x > 1 || be.y - bs.y > 1)
+            {
+                bs >>= 1;
+                be >>= 1;
+                ++level;
+            }
+            OMM_ASSERT(level < m.numAlphaRangeLevels);
+
+            const AlphaRange<eFormat>* range = (const AlphaRange<eFormat>*)m_dataAlphaRange + m.alphaRangeLevelOffset[level];
+            const int32_t width = m.alphaRangeLevelSize[level].x;
+
+            AlphaRange<eFormat> minMax = range[bs.x + bs.y * width];
+            for (int32_t y = bs.y; y <= be.y; ++y)
+            {
+                for (int32_t x = bs.x; x <= be.x; ++x)
+                {
+                    const AlphaRange<eFormat> r = range[x + y * width];
+                    minMax.x = std::min(minMax.x, r.x);
+                    minMax.y = std::max(minMax.y, r.y);
+                }
+            }
+
+            if constexpr (eFormat == ommCpuTextureFormat_UNORM8)
+                return float2(minMax) * (1.f / 255.f);
+            else
+                return minMax;
+        }
+
         template<class TMemoryStreamBuf>
         void Serialize(TMemoryStreamBuf& buffer) const;
 
@@ -134,6 +229,56 @@ namespace omm
 
         ommResult Validate(const ommCpuTextureDesc& desc) const;
         void Deallocate();
+        void BuildAlphaRange();
+        void BuildCutoffDistance();
+        void BuildSAT();
+        void AllocateSAT();
+        void BuildSATCounts();
+
+        bool UseInternalThreads() const
+        {
+            return (uint32_t)m_textureFlags & (uint32_t)ommCpuTextureFlags_EnableInternalThreads;
+        }
+
+        template<TilingMode eTilingMode, size_t kSizePerPixel>
+        static void CopyToTiled(uint8_t* dst, const uint8_t* src, const int2& size, size_t srcRowPitch, bool enableInternalThreads);
+
+        void SetSATBit(int32_t x, int32_t y, int32_t mip)
+        {
+            const Mips& m = m_mips[mip];
+            uint64_t* masks = (uint64_t*)(m_dataSAT + m.satMaskOffset);
+            masks[(x >> kSATBlockSizeLog2) + (y >> kSATBlockSizeLog2) * m.satNumBlocks.x] |= 1ull << (((y & kSATBlockMask) << kSATBlockSizeLog2) + (x & kSATBlockMask));
+        }
+
+        // Count of texels above the cutoff in [0, x] x [0, y]. The region splits at the 8x8 block holding (x, y) into
+        // the blocks above-left of it (corner), the partial columns above it (top), the partial rows left of it (left) and
+        // the part of the block itself, which is a popcount of its opacity bits.
+        uint32_t SATPrefix(int32_t x, int32_t y, int32_t mip) const
+        {
+            const Mips& m = m_mips[mip];
+            const int32_t bx = x >> kSATBlockSizeLog2;
+            const int32_t by = y >> kSATBlockSizeLog2;
+            const int32_t lx = x & kSATBlockMask;
+            const int32_t ly = y & kSATBlockMask;
+            const int32_t sx = x >> kSATSuperBlockSizeLog2;
+            const int32_t sy = y >> kSATSuperBlockSizeLog2;
+            const size_t blockIdx = bx + by * size_t(m.satNumBlocks.x);
+
+            const uint64_t mask = ((const uint64_t*)(m_dataSAT + m.satMaskOffset))[blockIdx];
+            const uint32_t corner = ((const uint32_t*)(m_dataSAT + m.satCornerOffset))[blockIdx];
+            const uint32_t top = ((const uint32_t*)(m_dataSAT + m.satTopBaseOffset))[x + sy * size_t(m.size.x)] +
+                ((const uint16_t*)(m_dataSAT + m.satTopOffset))[x + by * size_t(m.size.x)];
+            const uint32_t left = ((const uint32_t*)(m_dataSAT + m.satLeftBaseOffset))[y + sx * size_t(m.size.y)] +
+                ((const uint16_t*)(m_dataSAT + m.satLeftOffset))[y + bx * size_t(m.size.y)];
+
+            const uint64_t inBlock = GetSATColumnMask(lx) & GetSATRowMask(ly);
+            return corner + top + left + (uint32_t)std::popcount(mask & inBlock);
+        }
+
+        // Opacity bits of the columns [0, lx] and rows [0, ly] of a block.
+        static uint64_t GetSATColumnMask(int32_t lx) { return ((2ull << lx) - 1ull) * 0x0101010101010101ull; }
+        static uint64_t GetSATRowMask(int32_t ly) { return ~0ull >> ((kSATBlockMask - ly) << kSATBlockSizeLog2); }
+
         template<TilingMode eTilingMode>
         static uint32_t From2Dto1D(const int2& idx, const int2& size) {
             OMM_ASSERT(false && "Not implemented");
@@ -147,6 +292,17 @@ namespace omm
     private:
         static inline uint2  kMaxDim = int2(65536);
         static constexpr size_t kAlignment = 64;
+        static constexpr int32_t kBlockLinearTileSizeLog2 = 3;
+        // The finest level of the min/max pyramid holds one entry per 4x4 texels, each level above halves the grid.
+        static constexpr int32_t kAlphaRangeBlockSizeLog2 = 2;
+        static constexpr uint32_t kMaxAlphaRangeLevels = 16;
+        // The SAT keeps one opacity bit per texel in 8x8 blocks (one word each) and 32-bit counts at block corners. The
+        // partial strips above and left of a block are 16-bit counts, relative to a 32-bit base every 4096 texels so
+        // they cannot overflow. About 0.7 bytes per texel, against 4 for a plain 32-bit table.
+        static constexpr int32_t kSATBlockSizeLog2 = 3;
+        static constexpr int32_t kSATBlockMask = (1 << kSATBlockSizeLog2) - 1;
+        static constexpr int32_t kSATSuperBlockSizeLog2 = 12;
+        static_assert(kOpacityBlockSize == 1 << kSATBlockSizeLog2);
 
         StdAllocator<uint8_t> m_stdAllocator;
         const Logger& m_log;
@@ -161,7 +317,19 @@ namespace omm
             int2 sizeMinusOne;
             uintptr_t dataOffset;
             size_t numElements;
-            uintptr_t dataOffsetSAT;
+            const uint8_t* data; // m_data + dataOffset, or the caller's memory when referenced
+            size_t rowPitch; // in texels, linear tiling only
+            int2 satNumBlocks;
+            size_t satMaskOffset; // in bytes
+            size_t satCornerOffset;
+            size_t satTopOffset;
+            size_t satTopBaseOffset;
+            size_t satLeftOffset;
+            size_t satLeftBaseOffset;
+            uint32_t numAlphaRangeLevels;
+            int2 alphaRangeLevelSize[kMaxAlphaRangeLevels];
+            size_t alphaRangeLevelOffset[kMaxAlphaRangeLevels]; // in entries
+            size_t cutoffDistanceOffset;
         };
 
         vector<Mips> m_mips;
@@ -173,6 +341,8 @@ namespace omm
         size_t m_dataSize;
         uint8_t* m_dataSAT;
         size_t m_dataSATSize;
+        uint8_t* m_dataAlphaRange;
+        uint8_t* m_dataCutoffDistance;
     };
 
     template<ommCpuTextureFormat eFormat, TilingMode eTilingMode>
@@ -187,13 +357,14 @@ namespace omm
         OMM_ASSERT(texCoord.y < m_mips[mip].size.y);
         OMM_ASSERT(glm::all(glm::notEqual(texCoord, kTexCoordBorder2)));
         OMM_ASSERT(glm::all(glm::notEqual(texCoord, kTexCoordInvalid2)));
-        const uint64_t idx = From2Dto1D<eTilingMode>(texCoord, m_mips[mip].size);
-        OMM_ASSERT(idx < m_mips[mip].numElements);
+        const Mips& m = m_mips[mip];
+        const uint64_t idx = eTilingMode == TilingMode::Linear ? texCoord.x + texCoord.y * uint64_t(m.rowPitch) : From2Dto1D<eTilingMode>(texCoord, m.size);
+        OMM_ASSERT(idx < m.numElements);
 
         if constexpr (eFormat == ommCpuTextureFormat_FP32)
-            return ((float*)(m_data + m_mips[mip].dataOffset))[idx];
+            return ((const float*)m.data)[idx];
         else if constexpr (eFormat == ommCpuTextureFormat_UNORM8)
-            return (float)((uint8_t*)(m_data + m_mips[mip].dataOffset))[idx] * (1.f / 255.f);
+            return (float)((const uint8_t*)m.data)[idx] * (1.f / 255.f);
         else
         {
             assert(false);
@@ -224,6 +395,7 @@ namespace omm
 
    	template<> uint32_t TextureImpl::From2Dto1D<TilingMode::Linear>(const int2& idx, const int2& size);
    	template<> uint32_t TextureImpl::From2Dto1D<TilingMode::MortonZ>(const int2& idx, const int2& size);
+   	template<> uint32_t TextureImpl::From2Dto1D<TilingMode::BlockLinear>(const int2& idx, const int2& size);
 
     template<> uint2 TextureImpl::From1Dto2D<TilingMode::Linear>(const uint32_t idx, const int2& size);
     template<> uint2 TextureImpl::From1Dto2D<TilingMode::MortonZ>(const uint32_t idx, const int2& size);
@@ -245,25 +417,43 @@ namespace omm
                 os.write(reinterpret_cast<const char*>(&mip.size.y), sizeof(mip.size.y));
                 os.write(reinterpret_cast<const char*>(&mip.rcpSize.x), sizeof(mip.rcpSize.x));
                 os.write(reinterpret_cast<const char*>(&mip.rcpSize.y), sizeof(mip.rcpSize.y));
+                // Referenced data is written in the layout of a copied texture.
+                const size_t numElements = m_data == nullptr ? size_t(mip.size.x) * mip.size.y : mip.numElements;
                 os.write(reinterpret_cast<const char*>(&mip.dataOffset), sizeof(mip.dataOffset));
-                os.write(reinterpret_cast<const char*>(&mip.numElements), sizeof(mip.numElements));
-                os.write(reinterpret_cast<const char*>(&mip.dataOffsetSAT), sizeof(mip.dataOffsetSAT));
+                os.write(reinterpret_cast<const char*>(&numElements), sizeof(numElements));
+                const uintptr_t dataOffsetSAT = 0; // formerly the offset of a 32-bit SAT, it is now rebuilt on load
+                os.write(reinterpret_cast<const char*>(&dataOffsetSAT), sizeof(dataOffsetSAT));
             }
         }
 
         os.write(reinterpret_cast<const char*>(&m_tilingMode), sizeof(m_tilingMode));
-        os.write(reinterpret_cast<const char*>(&m_textureFlags), sizeof(m_textureFlags));
+        const ommCpuTextureFlags textureFlags = (ommCpuTextureFlags)((uint32_t)m_textureFlags & ~(uint32_t)ommCpuTextureFlags_ReferenceTextureData);
+        os.write(reinterpret_cast<const char*>(&textureFlags), sizeof(textureFlags));
         os.write(reinterpret_cast<const char*>(&m_alphaCutoff), sizeof(m_alphaCutoff));
         os.write(reinterpret_cast<const char*>(&m_textureFormat), sizeof(m_textureFormat));
 
         os.write(reinterpret_cast<const char*>(&m_dataSize), sizeof(m_dataSize));
-        os.write(reinterpret_cast<const char*>(m_data), m_dataSize);
-
-        os.write(reinterpret_cast<const char*>(&m_dataSATSize), sizeof(m_dataSATSize));
-        if (m_dataSATSize != 0)
+        if (m_data != nullptr)
         {
-            os.write(reinterpret_cast<const char*>(m_dataSAT), m_dataSATSize);
+            os.write(reinterpret_cast<const char*>(m_data), m_dataSize);
         }
+        else
+        {
+            const size_t sizePerPixel = m_textureFormat == ommCpuTextureFormat_FP32 ? sizeof(float) : sizeof(uint8_t);
+            const char padding[kAlignment] = {};
+            size_t offset = 0;
+            for (const auto& mip : m_mips)
+            {
+                os.write(padding, mip.dataOffset - offset);
+                for (int32_t y = 0; y < mip.size.y; ++y)
+                    os.write(reinterpret_cast<const char*>(mip.data + y * mip.rowPitch * sizePerPixel), mip.size.x * sizePerPixel);
+                offset = mip.dataOffset + mip.size.x * mip.size.y * sizePerPixel;
+            }
+            os.write(padding, m_dataSize - offset);
+        }
+
+        const size_t dataSATSize = 0;
+        os.write(reinterpret_cast<const char*>(&dataSATSize), sizeof(dataSATSize));
     }
 
     template<class TMemoryStreamBuf>
@@ -273,6 +463,8 @@ namespace omm
         OMM_ASSERT(m_dataSize == 0);
         OMM_ASSERT(m_dataSAT == nullptr);
         OMM_ASSERT(m_dataSATSize == 0);
+        OMM_ASSERT(m_dataAlphaRange == nullptr);
+        OMM_ASSERT(m_dataCutoffDistance == nullptr);
         OMM_ASSERT(m_mips.size() == 0);
 
         std::istream os(&buffer);
@@ -280,18 +472,20 @@ namespace omm
         int numMips = 0;
         os.read(reinterpret_cast<char*>(&numMips), sizeof(numMips));
 
+        vector<uintptr_t> legacyOffsetsSAT(numMips, 0, m_stdAllocator);
         if (numMips != 0)
         {
             m_mips.resize(numMips);
-            for (auto& mip : m_mips)
+            for (int mipIt = 0; mipIt < numMips; ++mipIt)
             {
+                Mips& mip = m_mips[mipIt];
                 os.read(reinterpret_cast<char*>(&mip.size.x), sizeof(mip.size.x));
                 os.read(reinterpret_cast<char*>(&mip.size.y), sizeof(mip.size.y));
                 os.read(reinterpret_cast<char*>(&mip.rcpSize.x), sizeof(mip.rcpSize.x));
                 os.read(reinterpret_cast<char*>(&mip.rcpSize.y), sizeof(mip.rcpSize.y));
                 os.read(reinterpret_cast<char*>(&mip.dataOffset), sizeof(mip.dataOffset));
                 os.read(reinterpret_cast<char*>(&mip.numElements), sizeof(mip.numElements));
-                os.read(reinterpret_cast<char*>(&mip.dataOffsetSAT), sizeof(mip.dataOffsetSAT));
+                os.read(reinterpret_cast<char*>(&legacyOffsetsSAT[mipIt]), sizeof(uintptr_t));
 
                 mip.sizeLog2.x = ctz(mip.size.x);
                 mip.sizeLog2.y = ctz(mip.size.y);
@@ -326,12 +520,49 @@ namespace omm
         os.read(reinterpret_cast<char*>(&m_dataSize), sizeof(m_dataSize));
         m_data = m_stdAllocator.allocate(m_dataSize, kAlignment);
         os.read(reinterpret_cast<char*>(m_data), m_dataSize);
+        for (Mips& mip : m_mips)
+        {
+            mip.data = m_data + mip.dataOffset;
+            mip.rowPitch = m_tilingMode == TilingMode::Linear ? mip.size.x : 0;
+        }
 
-        os.read(reinterpret_cast<char*>(&m_dataSATSize), sizeof(m_dataSATSize));
-        if (m_dataSATSize != 0)
+        size_t legacySATSize = 0;
+        os.read(reinterpret_cast<char*>(&legacySATSize), sizeof(legacySATSize));
+        if (legacySATSize != 0)
         {
-            m_dataSAT = m_stdAllocator.allocate(m_dataSATSize, kAlignment);
-            os.read(reinterpret_cast<char*>(m_dataSAT), m_dataSATSize);
+            // Older blobs store a 32-bit SAT per texel. Pre v3 blobs lack the alpha cutoff, so the opacity bits are
+            // recovered from the SAT itself rather than from the texels.
+            uint8_t* legacySAT = m_stdAllocator.allocate(legacySATSize, kAlignment);
+            os.read(reinterpret_cast<char*>(legacySAT), legacySATSize);
+
+            AllocateSAT();
+            for (int mipIt = 0; mipIt < numMips; ++mipIt)
+            {
+                const uint32_t* sat = (const uint32_t*)(legacySAT + legacyOffsetsSAT[mipIt]);
+                const int32_t w = m_mips[mipIt].size.x;
+                for (int j = 0; j < m_mips[mipIt].size.y; ++j)
+                {
+                    for (int i = 0; i < w; ++i)
+                    {
+                        const uint32_t A = i > 0 && j > 0 ? sat[(i - 1) + (j - 1) * w] : 0;
+                        const uint32_t B = j > 0 ? sat[i + (j - 1) * w] : 0;
+                        const uint32_t C = i > 0 ? sat[(i - 1) + j * w] : 0;
+                        if (sat[i + j * w] + A - B - C != 0)
+                            SetSATBit(i, j, mipIt);
+                    }
+                }
+            }
+            BuildSATCounts();
+
+            m_stdAllocator.deallocate(legacySAT, 0);
         }
+        else if (HasAlphaCutoff())
+        {
+            BuildSAT();
+        }
+
+        // The pyramid and the distances are derived from the texels, they are rebuilt rather than stored.
+        BuildAlphaRange();
+        BuildCutoffDistance();
     }
 }
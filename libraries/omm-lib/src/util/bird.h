@@ -180,5 +180,127 @@ namespace bird // is the word
 
 		return Triangle(uP0, uP1, uP2);
 	}
+
+	// Walks the micro-triangles in curve order, producing the same triangles as GetMicroTriangle.
+	// The discrete barycentrics are refined top down one index digit per level, stepping to the next index only redoes
+	// the trailing digits that wrapped around (4/3 levels on average). Neighbours on the curve share an edge, vertices
+	// of the previous micro-triangle are reused instead of being interpolated again.
+	class MicroTriangleIterator
+	{
+	public:
+		MicroTriangleIterator(const Triangle& t, uint32_t index, uint32_t subdivisionLevel)
+			: _t(t)
+			, _index(index)
+			, _subdivisionLevel(subdivisionLevel)
+		{
+			OMM_ASSERT(subdivisionLevel < kMaxNumLevels);
+			_levels[0] = { 0, 0, 0, 0, 0 };
+			Refine(subdivisionLevel);
+		}
+
+		uint32_t GetIndex() const { return _index; }
+
+		void Next()
+		{
+			++_index;
+			uint32_t numDigits = 1;
+			for (uint32_t index = _index; numDigits < _subdivisionLevel && (index & 3u) == 0; index >>= 2u)
+				++numDigits;
+			Refine(std::min(numDigits, _subdivisionLevel));
+		}
+
+		Triangle GetTriangle()
+		{
+			const Level& leaf = _levels[_subdivisionLevel];
+
+			uint32_t iu = leaf.u;
+			uint32_t iv = leaf.v;
+			int32_t d = 1;
+			// Level 0 has no digits, the parity below would flip the root triangle.
+			const bool upright = _subdivisionLevel == 0 || ((leaf.u ^ leaf.v ^ leaf.w) & 1u) != 0;
+			if (!upright)
+			{
+				iu = iu + 1;
+				iv = iv + 1;
+				d = -1;
+			}
+
+			const uint32_t keys[3] = {
+				PackKey(iu, iv),
+				PackKey(iu + d, iv),
+				PackKey(iu, iv + d),
+			};
+
+			float2 p[3];
+			for (uint32_t i = 0; i < 3; ++i)
+				p[i] = GetVertex(keys[i]);
+
+			for (uint32_t i = 0; i < 3; ++i)
+			{
+				_cachedKeys[i] = keys[i];
+				_cachedVertices[i] = p[i];
+			}
+
+			return Triangle(p[0], p[1], p[2]);
+		}
+
+	private:
+		static constexpr uint32_t kMaxNumLevels = 16;
+
+		// Discrete barycentrics and the running prefix XORs of index2dbary, per level.
+		struct Level
+		{
+			uint32_t u;
+			uint32_t v;
+			uint32_t w;
+			uint32_t fx;
+			uint32_t fy;
+		};
+
+		static uint32_t PackKey(uint32_t iu, uint32_t iv) { return (iu << 16u) | iv; }
+
+		// Recomputes the last numDigits levels from their common ancestor.
+		void Refine(uint32_t numDigits)
+		{
+			for (uint32_t level = _subdivisionLevel - numDigits; level < _subdivisionLevel; ++level)
+			{
+				const Level& parent = _levels[level];
+				const uint32_t digit = (_index >> ((_subdivisionLevel - 1u - level) << 1u)) & 3u;
+				const uint32_t b0 = digit & 1u;
+				const uint32_t b1 = digit >> 1u;
+
+				const uint32_t fx = parent.fx ^ b0;
+				const uint32_t fy = parent.fy ^ (b0 & ~b1 & 1u);
+				const uint32_t t = fy ^ b1;
+
+				const uint32_t u = ((fx & ~t) | (b0 & ~t) | (~b0 & ~fx & t)) & 1u;
+				const uint32_t v = fy ^ b0;
+				const uint32_t w = ((~fx & ~t) | (b0 & ~t) | (~b0 & fx & t)) & 1u;
+
+				_levels[level + 1] = { (parent.u << 1u) | u, (parent.v << 1u) | v, (parent.w << 1u) | w, fx, fy };
+			}
+		}
+
+		float2 GetVertex(uint32_t key) const
+		{
+			for (uint32_t i = 0; i < 3; ++i)
+			{
+				if (_cachedKeys[i] == key)
+					return _cachedVertices[i];
+			}
+
+			const uint32_t levelScalei = ((127u - _subdivisionLevel) << 23);
+			const float levelScale = reinterpret_cast<const float&>(levelScalei);
+			const float2 uv = { (float)(key >> 16u) * levelScale, (float)(key & 0xFFFFu) * levelScale };
+			return omm::InterpolateTriangleUV(InitBarycentrics(uv), _t);
+		}
+
+		const Triangle _t;
+		uint32_t _index;
+		uint32_t _subdivisionLevel;
+		Level _levels[kMaxNumLevels + 1];
+		uint32_t _cachedKeys[3] = { ~0u, ~0u, ~0u };
+		float2 _cachedVertices[3];
+	};
 } // namespace bird
 } // namespace omm
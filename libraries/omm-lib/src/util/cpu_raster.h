@@ -12,6 +12,10 @@ license agreement from NVIDIA CORPORATION is strictly prohibited.
 
 #include "math.h"
 #include "geometry.h"
+#include "cpu_raster_simd.h"
+
+#include <bit>
+#include <type_traits>
 
 namespace omm
 {
@@ -271,6 +275,59 @@ namespace omm
         FullyCovered,
     };
 
+    // Packs the edge functions of the over- or under-conservative test for the row coverage masks.
+    template <RasterMode eRasterMode>
+    inline raster::EdgeSetup GetConservativeEdgeSetup(const StatelessRasterizer& r, const float2& ext) {
+        static_assert(eRasterMode != RasterMode::Default);
+        const StatelessRasterizer::EdgeFn* edges[3] = { &r._e0, &r._e1, &r._e2 };
+
+        raster::EdgeSetup setup;
+        for (uint32_t k = 0; k < 3; ++k) {
+            const StatelessRasterizer::EdgeFn& e = *edges[k];
+            // Same offsets as EvalEdgeCons and EvalEdgeUnderCons.
+            const float bx = eRasterMode == RasterMode::OverConservative ? (e.N.x > 0 ? 0.f : e.N.x) : (e.N.x < 0 ? 0.f : e.N.x);
+            const float by = eRasterMode == RasterMode::OverConservative ? (e.N.y > 0 ? 0.f : e.N.y) : (e.N.y < 0 ? 0.f : e.N.y);
+            setup.nx[k] = e.N.x;
+            setup.ny[k] = e.N.y;
+            setup.c[k] = e.C;
+            setup.ox[k] = bx * ext.x;
+            setup.oy[k] = by * ext.y;
+        }
+        return setup;
+    }
+
+    // Kernels may return bool, returning false stops the raster of the current primitive.
+    // Kernels returning void visit every covered pixel.
+    template <typename F, typename... TArgs>
+    inline bool InvokeRasterKernel(F& f, TArgs&&... args) {
+        if constexpr (std::is_same_v<std::invoke_result_t<F&, TArgs...>, bool>)
+        {
+            return f(std::forward<TArgs>(args)...);
+        }
+        else
+        {
+            f(std::forward<TArgs>(args)...);
+            return true;
+        }
+    }
+
+    template <bool EnableBarycentrics, typename F>
+    constexpr bool IsTerminatingRasterKernel() {
+        if constexpr (EnableBarycentrics)
+            return std::is_same_v<std::invoke_result_t<F&, int2, float3*, void*>, bool>;
+        else
+            return std::is_same_v<std::invoke_result_t<F&, int2, void*>, bool>;
+    }
+
+    // Scales the triangle to pixel units. Rasterizer expects CCW triangles.
+    inline Triangle GetRasterSpaceTriangle(const Triangle& t, int2 r, const float2& offset, bool isCCW) {
+        const float2 rf = float2(r);
+        const Triangle rt = isCCW ? Triangle(t.p0 * rf + offset, t.p1 * rf + offset, t.p2 * rf + offset)
+                                  : Triangle(t.p2 * rf + offset, t.p1 * rf + offset, t.p0 * rf + offset);
+        OMM_ASSERT(rt.GetIsCCW());
+        return rt;
+    }
+
     // t - the triangle to rasterize
     // r - the pixel resolution to rasterize at.
     // f - the function callback, _should_ be inlined when using lambdas.
@@ -280,6 +337,7 @@ namespace omm
         // Obvious optimizations this rasterizer does _not_ do:
         // No coarse raster step - might be useful for large triangles,
         // Tight triangle traversal, right now it searches row wise and terminates on first exit.
+        // The conservative modes evaluate the edge functions for a whole run of pixels at once (SIMD, see cpu_raster_simd.h).
         
         // constexpr bool EnableBarycentrics = false;
 
@@ -288,12 +346,7 @@ namespace omm
         // Scanline approaches could be investigated as well.
         const bool isCCW = _t.GetIsCCW();
 
-        const float2 rf = float2(r);
-        const float2 invSize = 1.f / rf;
-        // Rasterizer expects CCW triangles.
-        Triangle t = isCCW ? Triangle(_t.p0 * rf + offset, _t.p1 * rf + offset, _t.p2 * rf + offset)
-                                    : Triangle(_t.p2 * rf + offset, _t.p1 * rf + offset, _t.p0 * rf + offset);
-        OMM_ASSERT(t.GetIsCCW());
+        const Triangle t = GetRasterSpaceTriangle(_t, r, offset, isCCW);
 
         const int2 min = int2{ glm::floor(t.aabb_s) };
         const int2 max = int2{ glm::ceil(t.aabb_e) };
@@ -305,73 +358,84 @@ namespace omm
 
         const float2 pixelSize(1, 1);
 
-        #pragma omp parallel for if (EnableParallel)
-        for (int y = min.y; y < max.y; ++y) {
-            bool wasInside = false;
+        // Early termination is only supported by the serial raster, where the remaining rows are skipped.
+        static_assert(!EnableParallel || !IsTerminatingRasterKernel<EnableBarycentrics, F>());
+        bool terminated = false;
 
-            for (int x = min.x; x < max.x; ++x) {
-                int2 it = int2({ x, y });
-                if constexpr (eRasterMode == RasterMode::OverConservative) {
-                    const float2 s = float2(x, y);
+        // s_c is the sample position of the barycentrics.
+        auto Visit = [&f, &_tix, isCCW, context](int x, int y, const float2& s_c) -> bool {
+            if constexpr (EnableBarycentrics)
+            {
+                float3 bc = _tix.GetBarycentrics(s_c);
+                if (!isCCW)
+                    bc = { bc.z, bc.y, bc.x };
+                return InvokeRasterKernel(f, int2({ x, y }), &bc, context);
+            }
+            else
+            {
+                return InvokeRasterKernel(f, int2({ x, y }), context);
+            }
+        };
 
-                    if (_tix.SquareInTriangleSkipAABBTest(s, pixelSize)) {
-                        const float2 s_c = (s + 0.5f);
+        if constexpr (eRasterMode == RasterMode::OverConservative || eRasterMode == RasterMode::UnderConservative) {
 
-                        if constexpr (EnableBarycentrics)
-                        {
-                            float3 bc = _tix.GetBarycentrics(s_c);
-                            if (!isCCW)
-                                bc = { bc.z, bc.y, bc.x };
+            const raster::EdgeSetup edges = GetConservativeEdgeSetup<eRasterMode>(_tix, pixelSize);
+            const raster::CoverageMaskFn coverageMask = raster::GetCoverageMaskFn();
 
-                            f(int2({ x, y }), &bc, context);
-                        }
-                        else
-                        {
-                           f(int2({ x, y }), context);
-                        }
-                        wasInside = true;
-                    }
-                    else if (wasInside)
-                        break;
-                } else if constexpr (eRasterMode == RasterMode::UnderConservative) {
+            #pragma omp parallel for if (EnableParallel)
+            for (int y = min.y; y < max.y; ++y) {
+                if (terminated)
+                    continue;
 
-                    const float2 s = float2(x, y);
+                bool wasInside = false;
+                bool rowDone = false;
 
-                    if (_tix.SquareEntierlyInTriangleSkipAABBTest(s, pixelSize)) {
-                        const float2 s_c = (s + 0.5f);
+                for (int x0 = min.x; x0 < max.x && !rowDone; x0 += (int)raster::kMaxMaskWidth) {
+                    const uint32_t count = (uint32_t)std::min<int>(raster::kMaxMaskWidth, max.x - x0);
+                    const uint64_t mask = coverageMask(edges, x0, y, count);
 
-                        if constexpr (EnableBarycentrics)
-                        {
-                            float3 bc = _tix.GetBarycentrics(s_c);
-                            if (!isCCW)
-                                bc = { bc.z, bc.y, bc.x };
+                    uint32_t i = 0;
+                    if (!wasInside) {
+                        if (mask == 0)
+                            continue;
+                        i = (uint32_t)std::countr_zero(mask);
+                    }
 
-                            f(int2({ x, y }), &bc, context);
+                    // Same traversal as the per pixel test, the row ends at the first uncovered pixel after a covered one.
+                    for (; i < count; ++i) {
+                        if (((mask >> i) & 1ull) == 0) {
+                            rowDone = true;
+                            break;
                         }
-                        else
-                        {
-                            f(int2({ x, y }), context);
+
+                        const int x = x0 + (int)i;
+                        if (!Visit(x, y, float2(x, y) + 0.5f)) {
+                            terminated = true;
+                            rowDone = true;
+                            break;
                         }
                         wasInside = true;
                     }
-                    else if (wasInside)
-                        break;
                 }
-                else if constexpr (eRasterMode == RasterMode::Default) {
+            }
+        }
+        else if constexpr (eRasterMode == RasterMode::Default) {
 
+            #pragma omp parallel for if (EnableParallel)
+            for (int y = min.y; y < max.y; ++y) {
+                if (terminated)
+                    continue;
+
+                bool wasInside = false;
+
+                for (int x = min.x; x < max.x; ++x) {
                     const float2 s = (float2(x, y) + 0.5f);
                     if (_tix.PointInTriangle(s, pixelSize)) 
                     {
-                        if constexpr (EnableBarycentrics)
+                        if (!Visit(x, y, s))
                         {
-                            float3 bc = _tix.GetBarycentrics(s);
-                            if (!isCCW)
-                                bc = { bc.z, bc.y, bc.x };
-                            f(int2({ x, y }), &bc, context);
-                        }
-                        else
-                        {
-                           f(int2({ x, y }), context);
+                            terminated = true;
+                            break;
                         }
                         wasInside = true;
                     }
@@ -382,6 +446,119 @@ namespace omm
         }
     }
 
+    // Result of a tile kernel in the tiled raster.
+    enum class TileResult {
+        Handled,    //< The whole tile was consumed by the tile kernel.
+        PerPixel,   //< No block level answer, visit the covered pixels of the tile one by one.
+        Terminate,  //< Stop the raster.
+    };
+
+    static constexpr int32_t kRasterTileSize = 8;
+
+    // Conservative raster with a coarse pass over kRasterTileSize^2 tiles aligned to the pixel grid.
+    // Tiles without coverage are skipped. Tiles where every pixel passes the eTileMode test (OverConservative: the pixel
+    // overlaps the triangle, UnderConservative: the pixel is inside) are handed to fTile(tileMin, tileMax, context),
+    // tileMax inclusive, so the kernel can use a block summary. Other tiles visit their over-conservative pixels with f.
+    // Tile kernels taking fTile(tileMin, tileMax, coverage, context) are instead handed every non-empty tile, coverage
+    // holds the over-conservative pixels of the tile with bit (y * kRasterTileSize + x) for pixel tileMin + (x, y).
+    // Pixels are visited tile by tile, kernels must not depend on the row wise order of RasterizeTriImpl.
+    template <RasterMode eTileMode, typename F, typename FTile>
+    inline void RasterizeConservativeTiledImpl(const Triangle& _t, int2 r, const float2& offset, F f, FTile fTile, void* context = nullptr) {
+        static_assert(eTileMode != RasterMode::Default);
+        static_assert(64 % kRasterTileSize == 0 && kRasterTileSize <= 8);
+
+        OMM_ASSERT(!_t.GetIsDegenerate());
+
+        const Triangle t = GetRasterSpaceTriangle(_t, r, offset, _t.GetIsCCW());
+
+        const int2 min = int2{ glm::floor(t.aabb_s) };
+        const int2 max = int2{ glm::ceil(t.aabb_e) };
+
+        OMM_ASSERT(min.x < max.x);
+        OMM_ASSERT(min.y < max.y);
+
+        const StatelessRasterizer _tix(t);
+        const float2 pixelSize(1, 1);
+
+        const raster::EdgeSetup edgesOver = GetConservativeEdgeSetup<RasterMode::OverConservative>(_tix, pixelSize);
+        const raster::EdgeSetup edgesTile = GetConservativeEdgeSetup<eTileMode>(_tix, pixelSize);
+        const raster::CoverageMaskFn coverageMask = raster::GetCoverageMaskFn();
+
+        auto AlignDown = [](int v) { return v - (((v % kRasterTileSize) + kRasterTileSize) % kRasterTileSize); };
+        constexpr uint32_t kTileRowMask = (1u << kRasterTileSize) - 1u;
+
+        for (int ty = AlignDown(min.y); ty < max.y; ty += kRasterTileSize) {
+            // Chunks of tiles along the band share the row masks.
+            for (int cx = AlignDown(min.x); cx < max.x; cx += (int)raster::kMaxMaskWidth) {
+
+                // Pixels outside of the triangle aabb are never visited.
+                const int xBegin = std::max(cx, min.x);
+                const int xEnd = std::min(cx + (int)raster::kMaxMaskWidth, max.x);
+                const uint64_t validMask = raster::LowBitsMask((uint32_t)(xEnd - cx)) & ~raster::LowBitsMask((uint32_t)(xBegin - cx));
+                const uint32_t count = (uint32_t)(xEnd - cx);
+
+                uint64_t over[kRasterTileSize];
+                uint64_t inside[kRasterTileSize];
+                for (int row = 0; row < kRasterTileSize; ++row) {
+                    const int y = ty + row;
+                    if (y < min.y || y >= max.y) {
+                        over[row] = 0;
+                        inside[row] = 0;
+                        continue;
+                    }
+                    over[row] = coverageMask(edgesOver, cx, y, count) & validMask;
+                    if constexpr (eTileMode == RasterMode::OverConservative)
+                        inside[row] = over[row];
+                    else
+                        inside[row] = coverageMask(edgesTile, cx, y, count) & validMask;
+                }
+
+                for (int tx = cx; tx < xEnd; tx += kRasterTileSize) {
+                    const uint32_t shift = (uint32_t)(tx - cx);
+
+                    bool isEmpty = true;
+                    bool isFull = true;
+                    for (int row = 0; row < kRasterTileSize; ++row) {
+                        isEmpty &= ((over[row] >> shift) & kTileRowMask) == 0;
+                        isFull &= ((inside[row] >> shift) & kTileRowMask) == kTileRowMask;
+                    }
+
+                    if (isEmpty)
+                        continue;
+
+                    if constexpr (std::is_invocable_v<FTile&, int2, int2, uint64_t, void*>) {
+                        uint64_t coverage = 0;
+                        for (int row = 0; row < kRasterTileSize; ++row)
+                            coverage |= ((over[row] >> shift) & kTileRowMask) << (row * kRasterTileSize);
+
+                        const TileResult result = fTile(int2(tx, ty), int2(tx + kRasterTileSize - 1, ty + kRasterTileSize - 1), coverage, context);
+                        if (result == TileResult::Terminate)
+                            return;
+                        if (result == TileResult::Handled)
+                            continue;
+                    }
+                    else if (isFull) {
+                        const TileResult result = fTile(int2(tx, ty), int2(tx + kRasterTileSize - 1, ty + kRasterTileSize - 1), context);
+                        if (result == TileResult::Terminate)
+                            return;
+                        if (result == TileResult::Handled)
+                            continue;
+                    }
+
+                    for (int row = 0; row < kRasterTileSize; ++row) {
+                        uint32_t bits = (uint32_t)((over[row] >> shift) & kTileRowMask);
+                        while (bits != 0) {
+                            const int x = tx + std::countr_zero(bits);
+                            bits &= bits - 1;
+                            if (!InvokeRasterKernel(f, int2({ x, ty + row }), context))
+                                return;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
     template <bool EnableParallel, bool EnableBarycentrics, typename F>
     inline void RasterizeLineImpl(const Line& _l, int2 r, const float2& offset, F f, void* context = nullptr)
     {
@@ -412,11 +589,13 @@ namespace omm
                 if constexpr (EnableBarycentrics)
                 {
                     const float3 zero(0, 0, 0);
-                    f(int2({ x, y }), &zero, context);
+                    if (!InvokeRasterKernel(f, int2({ x, y }), &zero, context))
+                        return;
                 }
                 else
                 {
-                    f(int2({ x, y }), context);
+                    if (!InvokeRasterKernel(f, int2({ x, y }), context))
+                        return;
                 }
 
                 if (D > 0)
@@ -448,11 +627,13 @@ namespace omm
                 if constexpr (EnableBarycentrics)
                 {
                     const float3 zero(0, 0, 0);
-                    f(int2({ x, y }), &zero, context);
+                    if (!InvokeRasterKernel(f, int2({ x, y }), &zero, context))
+                        return;
                 }
                 else
                 {
-                    f(int2({ x, y }), context);
+                    if (!InvokeRasterKernel(f, int2({ x, y }), context))
+                        return;
                 }
 
                 if (D > 0)
@@ -529,7 +710,7 @@ namespace omm
 
         if (stepX == 0 && stepY == 0)
         {
-            f(int2(x, y), context);
+            InvokeRasterKernel(f, int2(x, y), context);
             return;
         }
 
@@ -541,7 +722,8 @@ namespace omm
 
         while (x >= xMin && x <= xMax && y >= yMin && y <= yMax) 
         {
-            f(int2(x, y), context);
+            if (!InvokeRasterKernel(f, int2(x, y), context))
+                return;
 
             if (tMaxX < tMaxY) {
                 x += stepX;
@@ -566,6 +748,9 @@ namespace omm
     template <typename F>
     inline void RasterizeConservativeSerialWithOffsetCoverage(const Triangle& t, int2 r, float2 offset, F f, void* context = nullptr) { RasterizeTriImpl<RasterMode::OverConservative, false, false>(t, r, offset, f, context); };
 
+    template <typename F, typename FTile>
+    inline void RasterizeConservativeSerialWithOffsetTiled(const Triangle& t, int2 r, float2 offset, F f, FTile fTile, void* context = nullptr) { RasterizeConservativeTiledImpl<RasterMode::OverConservative>(t, r, offset, f, fTile, context); };
+
     template <typename F>
     inline void RasterizeConservativeParallel(const Triangle& t, int2 r, F f, void* context = nullptr) { RasterizeTriImpl<RasterMode::OverConservative, true, false>(t, r, float2{ 0,0 }, f, context); };
 
@@ -0,0 +1,215 @@
+/*
+Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+
+NVIDIA CORPORATION and its licensors retain all intellectual property
+and proprietary rights in and to this software, related documentation
+and any modifications thereto. Any use, reproduction, disclosure or
+distribution of this software and related documentation without an express
+license agreement from NVIDIA CORPORATION is strictly prohibited.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define OMM_RASTER_SIMD_X86 (1)
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define OMM_TARGET_AVX2
+#else
+#define OMM_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define OMM_RASTER_SIMD_X86 (0)
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define OMM_RASTER_SIMD_NEON (1)
+#include <arm_neon.h>
+#else
+#define OMM_RASTER_SIMD_NEON (0)
+#endif
+
+namespace omm
+{
+namespace raster
+{
+    // Conservative edge functions of a triangle, with the pixel extent offset (bx * ext.x, by * ext.y) folded in.
+    // A pixel at (x, y) is covered when (((nx * x + ny * y) + c) + ox) + oy < 0 for all three edges, the same
+    // sequence of operations as StatelessRasterizer::EvalEdgeCons so every path produces identical coverage.
+    struct EdgeSetup
+    {
+        float nx[3];
+        float ny[3];
+        float c[3];
+        float ox[3];
+        float oy[3];
+    };
+
+    static constexpr uint32_t kMaxMaskWidth = 64;
+
+    // Returns the coverage of pixels [x, x + count) on row y as a bit mask, count <= kMaxMaskWidth.
+    using CoverageMaskFn = uint64_t(*)(const EdgeSetup& e, int32_t x, int32_t y, uint32_t count);
+
+    inline uint64_t LowBitsMask(uint32_t count) {
+        return count >= kMaxMaskWidth ? ~0ull : ((1ull << count) - 1ull);
+    }
+
+    inline uint64_t CoverageMaskScalar(const EdgeSetup& e, int32_t x, int32_t y, uint32_t count)
+    {
+        uint64_t mask = 0;
+        const float yf = (float)y;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const float xf = (float)(x + (int32_t)i);
+            bool inside = true;
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                const float v = (((e.nx[k] * xf + e.ny[k] * yf) + e.c[k]) + e.ox[k]) + e.oy[k];
+                inside &= v < 0.f;
+            }
+            mask |= (uint64_t)inside << i;
+        }
+        return mask;
+    }
+
+#if OMM_RASTER_SIMD_X86
+    inline uint64_t CoverageMaskSSE(const EdgeSetup& e, int32_t x, int32_t y, uint32_t count)
+    {
+        const __m128 laneOffsets = _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+        const __m128 zero = _mm_setzero_ps();
+        const float yf = (float)y;
+
+        __m128 nx[3], nyY[3], c[3], ox[3], oy[3];
+        for (uint32_t k = 0; k < 3; ++k)
+        {
+            nx[k] = _mm_set1_ps(e.nx[k]);
+            nyY[k] = _mm_set1_ps(e.ny[k] * yf);
+            c[k] = _mm_set1_ps(e.c[k]);
+            ox[k] = _mm_set1_ps(e.ox[k]);
+            oy[k] = _mm_set1_ps(e.oy[k]);
+        }
+
+        uint64_t mask = 0;
+        for (uint32_t i = 0; i < count; i += 4)
+        {
+            const __m128 xf = _mm_add_ps(_mm_set1_ps((float)(x + (int32_t)i)), laneOffsets);
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                __m128 v = _mm_add_ps(_mm_mul_ps(nx[k], xf), nyY[k]);
+                v = _mm_add_ps(_mm_add_ps(_mm_add_ps(v, c[k]), ox[k]), oy[k]);
+                inside = _mm_and_ps(inside, _mm_cmplt_ps(v, zero));
+            }
+            mask |= (uint64_t)_mm_movemask_ps(inside) << i;
+        }
+        return mask & LowBitsMask(count);
+    }
+
+    OMM_TARGET_AVX2 inline uint64_t CoverageMaskAVX2(const EdgeSetup& e, int32_t x, int32_t y, uint32_t count)
+    {
+        const __m256 laneOffsets = _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f);
+        const __m256 zero = _mm256_setzero_ps();
+        const float yf = (float)y;
+
+        __m256 nx[3], nyY[3], c[3], ox[3], oy[3];
+        for (uint32_t k = 0; k < 3; ++k)
+        {
+            nx[k] = _mm256_set1_ps(e.nx[k]);
+            nyY[k] = _mm256_set1_ps(e.ny[k] * yf);
+            c[k] = _mm256_set1_ps(e.c[k]);
+            ox[k] = _mm256_set1_ps(e.ox[k]);
+            oy[k] = _mm256_set1_ps(e.oy[k]);
+        }
+
+        uint64_t mask = 0;
+        for (uint32_t i = 0; i < count; i += 8)
+        {
+            const __m256 xf = _mm256_add_ps(_mm256_set1_ps((float)(x + (int32_t)i)), laneOffsets);
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                __m256 v = _mm256_add_ps(_mm256_mul_ps(nx[k], xf), nyY[k]);
+                v = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(v, c[k]), ox[k]), oy[k]);
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(v, zero, _CMP_LT_OQ));
+            }
+            mask |= (uint64_t)_mm256_movemask_ps(inside) << i;
+        }
+        return mask & LowBitsMask(count);
+    }
+
+    inline bool IsAVX2Supported()
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+
+#if OMM_RASTER_SIMD_NEON
+    inline uint64_t CoverageMaskNEON(const EdgeSetup& e, int32_t x, int32_t y, uint32_t count)
+    {
+        static const float kLaneOffsets[4] = { 0.f, 1.f, 2.f, 3.f };
+        static const uint32_t kLaneBits[4] = { 1, 2, 4, 8 };
+        const float32x4_t laneOffsets = vld1q_f32(kLaneOffsets);
+        const uint32x4_t laneBits = vld1q_u32(kLaneBits);
+        const float32x4_t zero = vdupq_n_f32(0.f);
+        const float yf = (float)y;
+
+        float32x4_t nx[3], nyY[3], c[3], ox[3], oy[3];
+        for (uint32_t k = 0; k < 3; ++k)
+        {
+            nx[k] = vdupq_n_f32(e.nx[k]);
+            nyY[k] = vdupq_n_f32(e.ny[k] * yf);
+            c[k] = vdupq_n_f32(e.c[k]);
+            ox[k] = vdupq_n_f32(e.ox[k]);
+            oy[k] = vdupq_n_f32(e.oy[k]);
+        }
+
+        uint64_t mask = 0;
+        for (uint32_t i = 0; i < count; i += 4)
+        {
+            const float32x4_t xf = vaddq_f32(vdupq_n_f32((float)(x + (int32_t)i)), laneOffsets);
+            uint32x4_t inside = vdupq_n_u32(~0u);
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                float32x4_t v = vaddq_f32(vmulq_f32(nx[k], xf), nyY[k]);
+                v = vaddq_f32(vaddq_f32(vaddq_f32(v, c[k]), ox[k]), oy[k]);
+                inside = vandq_u32(inside, vcltq_f32(v, zero));
+            }
+            mask |= (uint64_t)vaddvq_u32(vandq_u32(inside, laneBits)) << i;
+        }
+        return mask & LowBitsMask(count);
+    }
+#endif
+
+    // Picks the widest path the CPU supports, resolved once per process.
+    inline CoverageMaskFn GetCoverageMaskFn()
+    {
+        static const CoverageMaskFn fn = []() -> CoverageMaskFn {
+#if OMM_RASTER_SIMD_X86
+            if (IsAVX2Supported())
+                return &CoverageMaskAVX2;
+            return &CoverageMaskSSE;
+#elif OMM_RASTER_SIMD_NEON
+            return &CoverageMaskNEON;
+#else
+            return &CoverageMaskScalar;
+#endif
+        }();
+        return fn;
+    }
+
+} // namespace raster
+} // namespace omm
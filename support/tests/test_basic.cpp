@@ -14,6 +14,9 @@ license agreement from NVIDIA CORPORATION is strictly prohibited.
 
 #include "util/omm.h"
 
+#include "omm_handle.h"
+#include "texture_impl.h"
+
 namespace {
 
 	TEST(Lib, VersionCheck) {
@@ -276,4 +279,265 @@ namespace {
 		EXPECT_EQ(omm::Cpu::CreateTexture(_baker, tex.GetDesc(), &outTexture), omm::Result::INVALID_ARGUMENT);
 	}
 
+	// GetTextureDesc exports the texels of every mip row by row, in whichever layout they are stored.
+	template<class T, omm::Cpu::TextureFormat Format>
+	static void TestGetTextureDesc(omm::Baker baker, bool enableZOrder, bool referenceData = false) {
+		vmtest::TextureImpl<T, Format> tex(1000, 600, 3, enableZOrder, -1.f /*alphaCutoff*/, [](int i, int j, int w, int h, int mip)->T {
+			return (T)((i * 3 + j * 5 + mip) % 251);
+		});
+		omm::Cpu::TextureDesc inDesc = tex.GetDesc();
+		if (referenceData)
+			inDesc.flags = (omm::Cpu::TextureFlags)((uint32_t)inDesc.flags | (uint32_t)omm::Cpu::TextureFlags::ReferenceTextureData);
+
+		omm::Cpu::Texture outTexture = 0;
+		ASSERT_EQ(omm::Cpu::CreateTexture(baker, inDesc, &outTexture), omm::Result::SUCCESS);
+
+		// The exported data is a copy, passing the desc back must not reference it.
+		omm::Cpu::TextureDesc outDesc;
+		EXPECT_EQ(omm::Cpu::GetTextureDesc(outTexture, &outDesc), omm::Result::SUCCESS);
+		ASSERT_EQ(outDesc.mipCount, inDesc.mipCount);
+		EXPECT_EQ((uint32_t)outDesc.flags, (uint32_t)inDesc.flags & ~(uint32_t)omm::Cpu::TextureFlags::ReferenceTextureData);
+
+		std::vector<omm::Cpu::TextureMipDesc> outMips(outDesc.mipCount);
+		std::vector<std::vector<T>> outData(outDesc.mipCount);
+		for (uint32_t mipIt = 0; mipIt < outDesc.mipCount; ++mipIt) {
+			outData[mipIt].resize(size_t(inDesc.mips[mipIt].width) * inDesc.mips[mipIt].height);
+			outMips[mipIt].textureData = outData[mipIt].data();
+		}
+		outDesc.mips = outMips.data();
+		EXPECT_EQ(omm::Cpu::GetTextureDesc(outTexture, &outDesc), omm::Result::SUCCESS);
+
+		for (uint32_t mipIt = 0; mipIt < outDesc.mipCount; ++mipIt) {
+			const omm::Cpu::TextureMipDesc& inMip = inDesc.mips[mipIt];
+			EXPECT_EQ(outMips[mipIt].width, inMip.width);
+			EXPECT_EQ(outMips[mipIt].height, inMip.height);
+
+			const T* inData = (const T*)inMip.textureData;
+			EXPECT_EQ(outData[mipIt], std::vector<T>(inData, inData + size_t(inMip.width) * inMip.height)) << "mip:" << mipIt;
+		}
+
+		EXPECT_EQ(omm::Cpu::DestroyTexture(baker, outTexture), omm::Result::SUCCESS);
+	}
+
+	TEST_F(TextureTest, GetTextureDesc1000x600) {
+		TestGetTextureDesc<float, omm::Cpu::TextureFormat::FP32>(_baker, true /*enableZorder*/);
+		TestGetTextureDesc<float, omm::Cpu::TextureFormat::FP32>(_baker, false /*enableZorder*/);
+		TestGetTextureDesc<uint8_t, omm::Cpu::TextureFormat::UNORM8>(_baker, true /*enableZorder*/);
+		TestGetTextureDesc<uint8_t, omm::Cpu::TextureFormat::UNORM8>(_baker, false /*enableZorder*/);
+	}
+
+	TEST_F(TextureTest, GetTextureDesc1000x600_ReferenceTextureData) {
+		TestGetTextureDesc<float, omm::Cpu::TextureFormat::FP32>(_baker, false /*enableZorder*/, true /*referenceData*/);
+		TestGetTextureDesc<uint8_t, omm::Cpu::TextureFormat::UNORM8>(_baker, false /*enableZorder*/, true /*referenceData*/);
+	}
+
+	static float SATPattern(int i, int j, int w, int h, int mip) {
+		return (i * 7 + j * 13 + (i * j) % 5) % 3 != 0 ? 1.f : 0.f;
+	}
+
+	// Compares TextureImpl::SAT to a count of the texels above the cutoff, on ranges that start and end on both sides of
+	// the 8x8 block and 4096 texel super-block edges.
+	static void TestSAT(omm::Baker baker, int w, int h, bool enableZOrder) {
+		const float alphaCutoff = 0.5f;
+		vmtest::TextureFP32 tex(w, h, 1, enableZOrder, alphaCutoff, &SATPattern);
+
+		omm::Cpu::Texture outTexture = 0;
+		ASSERT_EQ(omm::Cpu::CreateTexture(baker, tex.GetDesc(), &outTexture), omm::Result::SUCCESS);
+		const omm::TextureImpl* texture = omm::GetHandleImpl<omm::TextureImpl>(outTexture);
+		ASSERT_TRUE(texture->HasSAT());
+
+		std::vector<uint8_t> isAbove(size_t(w) * h);
+		for (int j = 0; j < h; ++j)
+			for (int i = 0; i < w; ++i)
+				isAbove[i + j * size_t(w)] = SATPattern(i, j, w, h, 0) > alphaCutoff;
+
+		auto GetCoords = [](int n) {
+			std::vector<int> coords = { 0, 1, 7, 8, 9, 15, 16, n / 2, 4095, 4096, 4097, n - 2, n - 1 };
+			coords.erase(std::remove_if(coords.begin(), coords.end(), [n](int c) { return c < 0 || c >= n; }), coords.end());
+			std::sort(coords.begin(), coords.end());
+			coords.erase(std::unique(coords.begin(), coords.end()), coords.end());
+			return coords;
+		};
+
+		const std::vector<int> coordsX = GetCoords(w);
+		const std::vector<int> coordsY = GetCoords(h);
+		for (size_t sx = 0; sx < coordsX.size(); ++sx) {
+			for (size_t ex = sx; ex < coordsX.size(); ++ex) {
+				for (size_t sy = 0; sy < coordsY.size(); ++sy) {
+					for (size_t ey = sy; ey < coordsY.size(); ++ey) {
+						const int2 s = int2(coordsX[sx], coordsY[sy]);
+						const int2 e = int2(coordsX[ex], coordsY[ey]);
+
+						uint32_t expected = 0;
+						for (int j = s.y; j <= e.y; ++j)
+							for (int i = s.x; i <= e.x; ++i)
+								expected += isAbove[i + j * size_t(w)];
+
+						EXPECT_EQ(texture->SAT(s, e, 0), expected) << "s:[" << s.x << "," << s.y << "] e:[" << e.x << "," << e.y << "]";
+					}
+				}
+			}
+		}
+
+		EXPECT_EQ(omm::Cpu::DestroyTexture(baker, outTexture), omm::Result::SUCCESS);
+	}
+
+	TEST_F(TextureTest, SAT4100x9) {
+		TestSAT(_baker, 4100, 9, true /*enableZorder*/);
+		TestSAT(_baker, 4100, 9, false /*enableZorder*/);
+	}
+
+	TEST_F(TextureTest, SAT9x4100) {
+		TestSAT(_baker, 9, 4100, true /*enableZorder*/);
+		TestSAT(_baker, 9, 4100, false /*enableZorder*/);
+	}
+
+	template<class T>
+	static T AlphaRangePattern(int i, int j, int w, int h, int mip) {
+		const uint32_t v = (i * 37 + j * 101 + (i * j) % 7 + mip * 13) % 256;
+		if constexpr (std::is_same_v<T, float>)
+			return (float)v / 255.f;
+		else
+			return (T)v;
+	}
+
+	// Compares TextureImpl::GetAlphaRange to the min and max of the texels it covers. The range is exact over the blocks of
+	// the first pyramid level where [s, e] spans at most 2x2 entries, and must hold every texel of [s, e].
+	template<class T, omm::Cpu::TextureFormat Format>
+	static void TestAlphaRange(omm::Baker baker, int w, int h, bool enableZOrder) {
+		const int mipCount = 2;
+		vmtest::TextureImpl<T, Format> tex(w, h, mipCount, enableZOrder, -1.f /*alphaCutoff*/, &AlphaRangePattern<T>);
+		const omm::Cpu::TextureDesc& desc = tex.GetDesc();
+
+		omm::Cpu::Texture outTexture = 0;
+		ASSERT_EQ(omm::Cpu::CreateTexture(baker, desc, &outTexture), omm::Result::SUCCESS);
+		const omm::TextureImpl* texture = omm::GetHandleImpl<omm::TextureImpl>(outTexture);
+		ASSERT_TRUE(texture->HasAlphaRange());
+
+		auto GetCoords = [](int n) {
+			std::vector<int> coords = { 0, 1, 3, 4, 5, 7, 8, 15, 16, 17, 32, 33, n / 2, n - 2, n - 1 };
+			coords.erase(std::remove_if(coords.begin(), coords.end(), [n](int c) { return c < 0 || c >= n; }), coords.end());
+			std::sort(coords.begin(), coords.end());
+			coords.erase(std::unique(coords.begin(), coords.end()), coords.end());
+			return coords;
+		};
+
+		for (int mip = 0; mip < mipCount; ++mip) {
+			const int mipW = (int)desc.mips[mip].width;
+			const int mipH = (int)desc.mips[mip].height;
+			const T* texels = (const T*)desc.mips[mip].textureData;
+
+			auto GetRange = [&](int2 s, int2 e) {
+				float2 range = float2(std::numeric_limits<float>::max(), -std::numeric_limits<float>::max());
+				for (int j = s.y; j <= e.y; ++j) {
+					for (int i = s.x; i <= e.x; ++i) {
+						const float alpha = std::is_same_v<T, float> ? (float)texels[i + j * mipW] : (float)texels[i + j * mipW] * (1.f / 255.f);
+						range = float2(std::min(range.x, alpha), std::max(range.y, alpha));
+					}
+				}
+				return range;
+			};
+
+			const std::vector<int> coordsX = GetCoords(mipW);
+			const std::vector<int> coordsY = GetCoords(mipH);
+			for (size_t sx = 0; sx < coordsX.size(); ++sx) {
+				for (size_t ex = sx; ex < coordsX.size(); ++ex) {
+					for (size_t sy = 0; sy < coordsY.size(); ++sy) {
+						for (size_t ey = sy; ey < coordsY.size(); ++ey) {
+							const int2 s = int2(coordsX[sx], coordsY[sy]);
+							const int2 e = int2(coordsX[ex], coordsY[ey]);
+
+							int32_t blockSizeLog2 = 2;
+							while ((e.x >> blockSizeLog2) - (s.x >> blockSizeLog2) > 1 || (e.y >> blockSizeLog2) - (s.y >> blockSizeLog2) > 1)
+								++blockSizeLog2;
+							const int2 footprintS = (s >> blockSizeLog2) << blockSizeLog2;
+							const int2 footprintE = glm::min((((e >> blockSizeLog2) + 1) << blockSizeLog2) - 1, int2(mipW - 1, mipH - 1));
+
+							const float2 range = texture->GetAlphaRange<(ommCpuTextureFormat)Format>(s, e, mip);
+							const float2 inner = GetRange(s, e);
+							const float2 expected = GetRange(footprintS, footprintE);
+							EXPECT_EQ(range, expected) << "mip:" << mip << " s:[" << s.x << "," << s.y << "] e:[" << e.x << "," << e.y << "]";
+							EXPECT_LE(range.x, inner.x);
+							EXPECT_GE(range.y, inner.y);
+						}
+					}
+				}
+			}
+		}
+
+		EXPECT_EQ(omm::Cpu::DestroyTexture(baker, outTexture), omm::Result::SUCCESS);
+	}
+
+	TEST_F(TextureTest, AlphaRange77x45_FP32) {
+		TestAlphaRange<float, omm::Cpu::TextureFormat::FP32>(_baker, 77, 45, true /*enableZorder*/);
+		TestAlphaRange<float, omm::Cpu::TextureFormat::FP32>(_baker, 77, 45, false /*enableZorder*/);
+	}
+
+	TEST_F(TextureTest, AlphaRange77x45_UNORM8) {
+		TestAlphaRange<uint8_t, omm::Cpu::TextureFormat::UNORM8>(_baker, 77, 45, true /*enableZorder*/);
+		TestAlphaRange<uint8_t, omm::Cpu::TextureFormat::UNORM8>(_baker, 77, 45, false /*enableZorder*/);
+	}
+
+	// Opaque left edge and sparse dots over the first eighth of the texture, so wide mips have texels beyond kMaxCutoffDistance.
+	// The last mip is uniform, there is no other side at all.
+	static float CutoffDistancePattern(int i, int j, int w, int h, int mip) {
+		if (mip == 2)
+			return 0.f;
+		return i < 3 || (i < w / 8 && (i * 7 + j * 13 + mip) % 11 == 0) ? 1.f : 0.f;
+	}
+
+	// Compares TextureImpl::GetCutoffDistance to a search for the nearest texel on the other side of the cutoff, on every
+	// odd sized mip. expectSaturated tells if some texel of the first mip is further than kMaxCutoffDistance from the edge.
+	static void TestCutoffDistance(omm::Baker baker, int w, int h, bool enableZOrder, bool expectSaturated) {
+		const float alphaCutoff = 0.5f;
+		const int mipCount = 3;
+		vmtest::TextureFP32 tex(w, h, mipCount, enableZOrder, alphaCutoff, &CutoffDistancePattern);
+		omm::Cpu::TextureDesc desc = tex.GetDesc();
+		desc.flags = (omm::Cpu::TextureFlags)((uint32_t)desc.flags | (uint32_t)omm::Cpu::TextureFlags::EnableCutoffDistance);
+
+		omm::Cpu::Texture outTexture = 0;
+		ASSERT_EQ(omm::Cpu::CreateTexture(baker, desc, &outTexture), omm::Result::SUCCESS);
+		const omm::TextureImpl* texture = omm::GetHandleImpl<omm::TextureImpl>(outTexture);
+		ASSERT_TRUE(texture->HasCutoffDistance());
+
+		bool saturated = false;
+		for (int mip = 0; mip < mipCount; ++mip) {
+			const int mipW = (int)desc.mips[mip].width;
+			const int mipH = (int)desc.mips[mip].height;
+
+			std::vector<uint8_t> isAbove(size_t(mipW) * mipH);
+			for (int j = 0; j < mipH; ++j)
+				for (int i = 0; i < mipW; ++i)
+					isAbove[i + j * size_t(mipW)] = CutoffDistancePattern(i, j, mipW, mipH, mip) > alphaCutoff;
+
+			for (int y = 0; y < mipH; ++y) {
+				for (int x = 0; x < mipW; ++x) {
+					uint32_t expected = omm::TextureImpl::kMaxCutoffDistance;
+					for (int j = 0; j < mipH; ++j) {
+						for (int i = 0; i < mipW; ++i) {
+							if (isAbove[i + j * size_t(mipW)] != isAbove[x + y * size_t(mipW)])
+								expected = std::min<uint32_t>(expected, (uint32_t)std::max(std::abs(i - x), std::abs(j - y)));
+						}
+					}
+					saturated |= mip == 0 && expected == omm::TextureImpl::kMaxCutoffDistance;
+
+					EXPECT_EQ(texture->GetCutoffDistance(int2(x, y), mip), expected) << "mip:" << mip << " [" << x << "," << y << "]";
+				}
+			}
+		}
+		EXPECT_EQ(saturated, expectSaturated);
+
+		EXPECT_EQ(omm::Cpu::DestroyTexture(baker, outTexture), omm::Result::SUCCESS);
+	}
+
+	TEST_F(TextureTest, CutoffDistance301x7) {
+		TestCutoffDistance(_baker, 301, 7, true /*enableZorder*/, true /*expectSaturated*/);
+		TestCutoffDistance(_baker, 301, 7, false /*enableZorder*/, true /*expectSaturated*/);
+	}
+
+	TEST_F(TextureTest, CutoffDistance61x37) {
+		TestCutoffDistance(_baker, 61, 37, true /*enableZorder*/, false /*expectSaturated*/);
+		TestCutoffDistance(_baker, 61, 37, false /*enableZorder*/, false /*expectSaturated*/);
+	}
+
 }  // namespace
@@ -14,6 +14,7 @@ license agreement from NVIDIA CORPORATION is strictly prohibited.
 #include "util/omm_histogram.h"
 
 #include <stb_image.h>
+#include <xxhash.h>
 
 #include <omm.h>
 #include "util/bird.h"
@@ -26,6 +27,7 @@ license agreement from NVIDIA CORPORATION is strictly prohibited.
 #include <vector>
 #include <istream>
 #include <iterator>
+#include <cstring>
 
 namespace {
 
@@ -59,6 +61,7 @@ namespace {
 		bool serializeCompress = false;
 		omm::SpecialIndex unresolvedTriState = omm::SpecialIndex::FullyUnknownOpaque;
 		float dynamicSubdivisionScale = 0.f;
+		float texCoordQuantization = 0.f;
 	};
 
 	static float StandardCircle(int i, int j, int w, int h, int mip)
@@ -102,6 +105,47 @@ namespace {
 			return tex;
 		}
 
+		// Alpha test of UV32_FLOAT triangles against a 0.5 cutoff, special indices are disabled so the result can be read by BakeStates.
+		omm::Cpu::BakeInputDesc GetBakeInputDesc(omm::Cpu::Texture texHandle, const uint32_t* triangleIndices, uint32_t indexCount, const float* texCoords,
+			omm::TextureAddressMode addressingMode, omm::TextureFilterMode filter, uint32_t maxSubdivisionLevel, omm::Cpu::BakeFlags flags = omm::Cpu::BakeFlags::None) {
+			omm::Cpu::BakeInputDesc desc;
+			desc.texture = texHandle;
+			desc.alphaMode = omm::AlphaMode::Test;
+			desc.runtimeSamplerDesc.addressingMode = addressingMode;
+			desc.runtimeSamplerDesc.filter = filter;
+			desc.indexFormat = omm::IndexFormat::UINT_32;
+			desc.indexBuffer = triangleIndices;
+			desc.indexCount = indexCount;
+			desc.texCoords = texCoords;
+			desc.texCoordFormat = omm::TexCoordFormat::UV32_FLOAT;
+			desc.maxSubdivisionLevel = maxSubdivisionLevel;
+			desc.alphaCutoff = 0.5f;
+			desc.bakeFlags = (omm::Cpu::BakeFlags)((uint32_t)omm::Cpu::BakeFlags::EnableInternalThreads | (uint32_t)omm::Cpu::BakeFlags::DisableSpecialIndices | (uint32_t)flags);
+			return desc;
+		}
+
+		// Micro-triangle states of every primitive, the desc must set DisableSpecialIndices and use a 4-state format.
+		std::vector<std::vector<uint32_t>> BakeStates(const omm::Cpu::BakeInputDesc& desc) {
+			omm::Cpu::BakeResult res = nullptr;
+			const omm::Cpu::BakeResultDesc* resDesc = nullptr;
+			EXPECT_EQ(omm::Cpu::Bake(_baker, desc, &res), omm::Result::SUCCESS);
+			EXPECT_EQ(omm::Cpu::GetBakeResultDesc(res, &resDesc), omm::Result::SUCCESS);
+
+			std::vector<std::vector<uint32_t>> states(desc.indexCount / 3);
+			for (uint32_t i = 0; i < states.size(); ++i)
+			{
+				const int32_t ommIndex = resDesc->indexFormat == omm::IndexFormat::UINT_16 ? ((const int16_t*)resDesc->indexBuffer)[i] : ((const int32_t*)resDesc->indexBuffer)[i];
+				EXPECT_GE(ommIndex, 0);
+				const omm::Cpu::OpacityMicromapDesc& ommDesc = resDesc->descArray[ommIndex];
+				const uint8_t* data = (const uint8_t*)resDesc->arrayData + ommDesc.offset;
+				for (uint32_t j = 0; j < omm::bird::GetNumMicroTriangles(ommDesc.subdivisionLevel); ++j)
+					states[i].push_back((data[j / 4] >> ((j % 4) * 2)) & 3);
+			}
+
+			EXPECT_EQ(omm::Cpu::DestroyBakeResult(res), omm::Result::SUCCESS);
+			return states;
+		}
+
 		void ExpectEqual(const omm::Debug::Stats& stats, const omm::Debug::Stats& expectedStats) {
 			EXPECT_EQ(stats.totalOpaque, expectedStats.totalOpaque);
 			EXPECT_EQ(stats.totalTransparent, expectedStats.totalTransparent);
@@ -205,6 +249,7 @@ namespace {
 				desc.bakeFlags = (omm::Cpu::BakeFlags)((uint32_t)desc.bakeFlags | (uint32_t)omm::Cpu::BakeFlags::DisableSpecialIndices);
 
 			desc.dynamicSubdivisionScale = opt.dynamicSubdivisionScale;
+			desc.texCoordQuantization = opt.texCoordQuantization;
 
 			omm::Cpu::BakeResult res = nullptr;
 			const omm::Cpu::BakeResultDesc* resDesc = nullptr;
@@ -380,6 +425,14 @@ namespace {
 				EXPECT_EQ(omm::Debug::GetStats(_baker, resDesc, &output.stats), omm::Result::SUCCESS);
 			}
 
+			if (res)
+			{
+				omm::Debug::Stats resStats;
+				EXPECT_EQ(omm::Debug::GetStats2(_baker, res, &resStats), omm::Result::SUCCESS);
+				EXPECT_TRUE(resStats.threadUtilization == -1.f || (resStats.threadUtilization >= 0.f && resStats.threadUtilization <= 1.f));
+				EXPECT_EQ(resStats.texCoordQuantization, opt.texCoordQuantization);
+			}
+
 			omm::Test::ValidateHistograms(resDesc);
 
 			EXPECT_EQ(omm::Cpu::DestroyBakeResult(res), omm::Result::SUCCESS);
@@ -963,6 +1016,148 @@ namespace {
 			});
 	}
 
+	TEST_P(OMMBakeTestCPU, CircleCutoffDistance) {
+
+		uint32_t subdivisionLevel = 4;
+
+		vmtest::TextureFP32 texture(1024, 1024, 1, EnableZOrder(), 0.5f, &StandardCircle);
+		omm::Cpu::TextureDesc desc = texture.GetDesc();
+		desc.flags = (omm::Cpu::TextureFlags)((uint32_t)desc.flags | (uint32_t)omm::Cpu::TextureFlags::EnableCutoffDistance);
+		omm::Cpu::Texture texHandle = CreateTexture(desc);
+
+		uint32_t triangleIndices[6] = { 0, 1, 2, 3, 1, 2 };
+		float texCoords[8] = { 0.f, 0.f,	0.f, 1.f,	1.f, 0.f,	 1.f, 1.f };
+		omm::Debug::Stats stats = GetOmmBakeStats(0.5f, subdivisionLevel, { 1024, 1024 }, 6, triangleIndices, omm::TexCoordFormat::UV32_FLOAT, texCoords, texHandle);
+
+		ExpectEqual(stats, {
+			.totalOpaque = 204,
+			.totalTransparent = 219,
+			.totalUnknownTransparent = 39,
+			.totalUnknownOpaque = 50,
+			});
+	}
+
+	TEST_P(OMMBakeTestCPU, CircleReferenceTextureData) {
+
+		uint32_t subdivisionLevel = 4;
+
+		// Padded rows, referenced in place.
+		const uint32_t size = 1024;
+		const uint32_t rowPitch = size + 16;
+		std::vector<float> data(size_t(rowPitch) * size, -1.f);
+		for (uint32_t j = 0; j < size; ++j)
+			for (uint32_t i = 0; i < size; ++i)
+				data[i + j * rowPitch] = StandardCircle(i, j, size, size, 0);
+
+		omm::Cpu::TextureMipDesc mip;
+		mip.width = size;
+		mip.height = size;
+		mip.rowPitch = rowPitch * sizeof(float);
+		mip.textureData = data.data();
+
+		omm::Cpu::TextureDesc desc;
+		desc.format = omm::Cpu::TextureFormat::FP32;
+		desc.flags = (omm::Cpu::TextureFlags)((uint32_t)omm::Cpu::TextureFlags::DisableZOrder | (uint32_t)omm::Cpu::TextureFlags::ReferenceTextureData);
+		desc.mips = &mip;
+		desc.mipCount = 1;
+		desc.alphaCutoff = EnableAlphaCutoff() ? 0.5f : -1.f;
+		omm::Cpu::Texture texHandle = CreateTexture(desc);
+
+		uint32_t triangleIndices[6] = { 0, 1, 2, 3, 1, 2 };
+		float texCoords[8] = { 0.f, 0.f,	0.f, 1.f,	1.f, 0.f,	 1.f, 1.f };
+		omm::Debug::Stats stats = GetOmmBakeStats(0.5f, subdivisionLevel, { size, size }, 6, triangleIndices, omm::TexCoordFormat::UV32_FLOAT, texCoords, texHandle);
+
+		ExpectEqual(stats, {
+			.totalOpaque = 204,
+			.totalTransparent = 219,
+			.totalUnknownTransparent = 39,
+			.totalUnknownOpaque = 50,
+			});
+	}
+
+	TEST_P(OMMBakeTestCPU, CircleWrapRotatedReuse) {
+
+		vmtest::TextureFP32 texture(1024, 1024, 1, EnableZOrder(), EnableAlphaCutoff() ? 0.5f : -1.f, &StandardCircle);
+		omm::Cpu::Texture texHandle = CreateTexture(texture.GetDesc());
+
+		// The second quad repeats the first one a few texture periods away, with rotated vertex order.
+		uint32_t triangleIndices[12] = { 0, 1, 2, 3, 1, 2,	5, 6, 4, 5, 6, 7 };
+		float texCoords[16] = { 0.f, 0.f,	0.f, 1.f,	1.f, 0.f,	 1.f, 1.f,
+								2.f, -3.f,	2.f, -2.f,	3.f, -3.f,	 3.f, -2.f };
+
+		auto GetDesc = [&](omm::Cpu::BakeFlags flags) {
+			return GetBakeInputDesc(texHandle, triangleIndices, 12, texCoords, omm::TextureAddressMode::Wrap, omm::TextureFilterMode::Linear, 4, flags);
+		};
+
+		// Reusing the translated and rotated triangles must match baking each one on its own.
+		EXPECT_EQ(BakeStates(GetDesc(omm::Cpu::BakeFlags::None)), BakeStates(GetDesc(omm::Cpu::BakeFlags::DisableDuplicateDetection)));
+	}
+
+	TEST_P(OMMBakeTestCPU, CircleTexCoordQuantization) {
+
+		vmtest::TextureFP32 texture(64, 64, 1, EnableZOrder(), EnableAlphaCutoff() ? 0.5f : -1.f, &StandardCircle);
+		omm::Cpu::Texture texHandle = CreateTexture(texture.GetDesc());
+
+		// The second quad is the first one off by 0.3 texels. That changes the baked states, so only snapping to whole
+		// texels lets the quads share their OMMs.
+		const float jitter = 0.3f / 64.f;
+		uint32_t triangleIndices[12] = { 0, 1, 2, 3, 1, 2,	4, 5, 6, 7, 5, 6 };
+		float texCoords[16] = { 0.f, 0.f,	0.f, 1.f,	1.f, 0.f,	 1.f, 1.f,
+								jitter, 0.f,	0.f, 1.f + jitter,	1.f, jitter,	 1.f + jitter, 1.f };
+
+		auto BakeIndices = [&](float texCoordQuantization) {
+			omm::Cpu::BakeInputDesc desc = GetBakeInputDesc(texHandle, triangleIndices, 12, texCoords, omm::TextureAddressMode::Clamp, omm::TextureFilterMode::Linear, 5);
+			desc.texCoordQuantization = texCoordQuantization;
+
+			omm::Cpu::BakeResult res = nullptr;
+			const omm::Cpu::BakeResultDesc* resDesc = nullptr;
+			EXPECT_EQ(omm::Cpu::Bake(_baker, desc, &res), omm::Result::SUCCESS);
+			EXPECT_EQ(omm::Cpu::GetBakeResultDesc(res, &resDesc), omm::Result::SUCCESS);
+
+			std::vector<int32_t> ommIndices;
+			for (uint32_t i = 0; i < 4; ++i)
+				ommIndices.push_back(resDesc->indexFormat == omm::IndexFormat::UINT_16 ? ((const int16_t*)resDesc->indexBuffer)[i] : ((const int32_t*)resDesc->indexBuffer)[i]);
+			EXPECT_EQ(resDesc->descArrayCount, texCoordQuantization > 0.f ? 2u : 4u);
+
+			EXPECT_EQ(omm::Cpu::DestroyBakeResult(res), omm::Result::SUCCESS);
+			return ommIndices;
+		};
+
+		const std::vector<int32_t> unquantized = BakeIndices(0.f);
+		EXPECT_NE(unquantized[0], unquantized[2]);
+		EXPECT_NE(unquantized[1], unquantized[3]);
+
+		const std::vector<int32_t> quantized = BakeIndices(1.f);
+		EXPECT_EQ(quantized[0], quantized[2]);
+		EXPECT_EQ(quantized[1], quantized[3]);
+		EXPECT_NE(quantized[0], quantized[1]);
+	}
+
+	TEST_P(OMMBakeTestCPU, NonSquareBlockLinear) {
+
+		// Z-order textures that are not power of two squares are stored in 8x8 tiles, every mip must bake as the linear layout.
+		auto Pattern = [](int i, int j, int w, int h, int mip)->float {
+			return 0.5f + 0.5f * std::sin(0.031f * i + 0.6f * mip) * std::cos(0.047f * j);
+		};
+
+		const float alphaCutoff = EnableAlphaCutoff() ? 0.5f : -1.f;
+		vmtest::TextureFP32 tiled(1000, 600, 3, true /*enableZorder*/, alphaCutoff, Pattern);
+		vmtest::TextureFP32 linear(1000, 600, 3, false /*enableZorder*/, alphaCutoff, Pattern);
+		omm::Cpu::Texture tiledHandle = CreateTexture(tiled.GetDesc());
+		omm::Cpu::Texture linearHandle = CreateTexture(linear.GetDesc());
+
+		// A quad over the texture and a triangle whose edges cross tiles near the padded right and bottom borders.
+		uint32_t triangleIndices[9] = { 0, 1, 2, 3, 1, 2,	4, 5, 6 };
+		float texCoords[14] = { 0.f, 0.f,	0.f, 1.f,	1.f, 0.f,	 1.f, 1.f,
+								0.9f, 0.1f,	0.999f, 0.5f,	0.7f, 0.998f };
+
+		auto BakeTexture = [&](omm::Cpu::Texture texHandle) {
+			return BakeStates(GetBakeInputDesc(texHandle, triangleIndices, 9, texCoords, omm::TextureAddressMode::Clamp, omm::TextureFilterMode::Linear, 6));
+		};
+
+		EXPECT_EQ(BakeTexture(tiledHandle), BakeTexture(linearHandle));
+	}
+
 	TEST_P(OMMBakeTestCPU, CircleMergeSimilar) {
 
 		uint32_t subdivisionLevel = 4;
@@ -2296,6 +2491,143 @@ namespace {
 			});
 	}
 
+	TEST_P(OMMBakeTestCPU, DeserializeInput_LegacySAT_v4) {
+
+		// Version 4 blobs store a 32-bit SAT per texel of every mip, the opacity bits are recovered from it on load. The blob
+		// is written field by field in the version 4 layout, with a linear texture of two odd sized mips.
+		const float alphaCutoff = 0.5f;
+		vmtest::TextureFP32 texture(37, 29, 2, false /*enableZorder*/, alphaCutoff, &StandardCircle);
+		const omm::Cpu::TextureDesc& texDesc = texture.GetDesc();
+		omm::Cpu::Texture texHandle = CreateTexture(texDesc);
+
+		uint32_t triangleIndices[6] = { 0, 1, 2, 3, 1, 2 };
+		float texCoords[8] = { 0.f, 0.f,	0.f, 1.f,	1.f, 0.f,	 1.f, 1.f };
+
+		const omm::Cpu::BakeInputDesc desc = GetBakeInputDesc(texHandle, triangleIndices, 6, texCoords, omm::TextureAddressMode::Clamp, omm::TextureFilterMode::Linear, 5);
+
+		auto Align = [](size_t offset) { return (offset + 63) & ~size_t(63); };
+
+		std::vector<uint8_t> texels;
+		std::vector<uint8_t> legacySAT;
+		std::vector<size_t> dataOffsets;
+		std::vector<size_t> satOffsets;
+		for (uint32_t mipIt = 0; mipIt < texDesc.mipCount; ++mipIt)
+		{
+			const omm::Cpu::TextureMipDesc& mip = texDesc.mips[mipIt];
+			const float* mipTexels = (const float*)mip.textureData;
+
+			dataOffsets.push_back(texels.size());
+			texels.resize(Align(texels.size() + sizeof(float) * mip.width * mip.height));
+			std::memcpy(texels.data() + dataOffsets.back(), mipTexels, sizeof(float) * mip.width * mip.height);
+
+			satOffsets.push_back(legacySAT.size());
+			legacySAT.resize(Align(legacySAT.size() + sizeof(uint32_t) * mip.width * mip.height));
+			uint32_t* sat = (uint32_t*)(legacySAT.data() + satOffsets.back());
+			for (uint32_t j = 0; j < mip.height; ++j)
+			{
+				for (uint32_t i = 0; i < mip.width; ++i)
+				{
+					uint32_t count = mipTexels[i + j * mip.width] > alphaCutoff;
+					if (i > 0)
+						count += sat[(i - 1) + j * mip.width];
+					if (j > 0)
+						count += sat[i + (j - 1) * mip.width];
+					if (i > 0 && j > 0)
+						count -= sat[(i - 1) + (j - 1) * mip.width];
+					sat[i + j * mip.width] = count;
+				}
+			}
+		}
+
+		std::vector<uint8_t> blob;
+		auto WriteBytes = [&blob](const void* data, size_t size) {
+			blob.insert(blob.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+		};
+		auto Write = [&WriteBytes](const auto& value) {
+			WriteBytes(&value, sizeof(value));
+		};
+
+		// Header, the digest is filled in last.
+		Write(uint64_t(0));
+		Write(int(OMM_VERSION_MAJOR));
+		Write(int(OMM_VERSION_MINOR));
+		Write(int(OMM_VERSION_BUILD));
+		Write(int(4) /*inputDescVersion*/);
+		Write(int(0) /*flags*/);
+		Write(int(0) /*decompressedSize*/);
+
+		Write(int(1) /*numInputDescs*/);
+		Write(desc.bakeFlags);
+
+		// Texture
+		Write(int(texDesc.mipCount));
+		for (uint32_t mipIt = 0; mipIt < texDesc.mipCount; ++mipIt)
+		{
+			const omm::Cpu::TextureMipDesc& mip = texDesc.mips[mipIt];
+			Write(int(mip.width));
+			Write(int(mip.height));
+			Write(1.f / mip.width);
+			Write(1.f / mip.height);
+			Write(uintptr_t(dataOffsets[mipIt]));
+			Write(size_t(mip.width) * mip.height /*numElements*/);
+			Write(uintptr_t(satOffsets[mipIt]));
+		}
+		Write(int(0) /*TilingMode::Linear*/);
+		Write(texDesc.flags);
+		Write(texDesc.alphaCutoff);
+		Write(texDesc.format);
+		Write(texels.size());
+		WriteBytes(texels.data(), texels.size());
+		Write(legacySAT.size());
+		WriteBytes(legacySAT.data(), legacySAT.size());
+
+		Write(desc.runtimeSamplerDesc.addressingMode);
+		Write(desc.runtimeSamplerDesc.filter);
+		Write(desc.runtimeSamplerDesc.borderAlpha);
+		Write(desc.alphaMode);
+		Write(desc.texCoordFormat);
+		Write(sizeof(texCoords));
+		WriteBytes(texCoords, sizeof(texCoords));
+		Write(desc.texCoordStrideInBytes);
+		Write(desc.indexFormat);
+		Write(desc.indexCount);
+		WriteBytes(triangleIndices, sizeof(triangleIndices));
+		Write(desc.dynamicSubdivisionScale);
+		Write(desc.rejectionThreshold);
+		Write(desc.alphaCutoff);
+		Write(desc.alphaCutoffLessEqual);
+		Write(desc.alphaCutoffGreater);
+		Write(desc.format);
+		Write(size_t(0) /*numFormats*/);
+		Write(desc.unknownStatePromotion);
+		Write(desc.unresolvedTriState);
+		Write(desc.maxSubdivisionLevel);
+		Write(desc.maxArrayDataSize);
+		Write(size_t(0) /*numSubdivLvls*/);
+		Write(desc.maxWorkloadSize);
+
+		Write(int(0) /*numResultDescs*/);
+
+		const XXH64_hash_t digest = XXH64(blob.data() + sizeof(XXH64_hash_t), blob.size() - sizeof(XXH64_hash_t), 42 /*seed*/);
+		std::memcpy(blob.data(), &digest, sizeof(digest));
+
+		omm::Cpu::BlobDesc blobDesc;
+		blobDesc.data = blob.data();
+		blobDesc.size = blob.size();
+
+		omm::Cpu::DeserializedResult dRes = nullptr;
+		ASSERT_EQ(omm::Cpu::Deserialize(_baker, blobDesc, &dRes), omm::Result::SUCCESS);
+
+		const omm::Cpu::DeserializedDesc* desDesc = nullptr;
+		EXPECT_EQ(omm::Cpu::GetDeserializedDesc(dRes, &desDesc), omm::Result::SUCCESS);
+		ASSERT_EQ(desDesc->numInputDescs, 1);
+		EXPECT_EQ(desDesc->numResultDescs, 0);
+
+		EXPECT_EQ(BakeStates(desDesc->inputDescs[0]), BakeStates(desc));
+
+		EXPECT_EQ(omm::Cpu::DestroyDeserializedResult(dRes), omm::Result::SUCCESS);
+	}
+
 	TEST_P(OMMBakeTestCPU, Degen_Default_lvl1) {
 
 		uint32_t triangleIndices[3] = { 0, 1, 2, };
@@ -14,6 +14,7 @@ license agreement from NVIDIA CORPORATION is strictly prohibited.
 #include "util/cpu_raster.h"
 #include <omp.h>
 #include <algorithm>
+#include <chrono>
 #include <filesystem>
 
 namespace {
@@ -219,6 +220,167 @@ TEST_P(RasterTest, RasterizeConservativeSuperLarge) {
 	Run({ _size.x * 4, _size.y * 4, }, omm::RasterMode::OverConservative, false);
 }
 
+TEST_P(RasterTest, RasterizeConservativeEarlyOut) {
+	uint32_t numCovered = 0;
+	omm::RasterizeConservativeSerial(_triangle, _size, [&numCovered](int2, void*) { numCovered++; });
+	EXPECT_GT(numCovered, 0u);
+
+	const uint32_t maxVisits = std::min(numCovered, 3u);
+	uint32_t numVisited = 0;
+	omm::RasterizeConservativeSerial(_triangle, _size, [&numVisited, maxVisits](int2, void*) -> bool { return ++numVisited < maxVisits; });
+	EXPECT_EQ(numVisited, maxVisits);
+}
+
+TEST_P(RasterTest, RasterizeCoverageMask) {
+	const float2 rf = float2(_size);
+	const omm::Triangle t(_triangle.p0 * rf, _triangle.p1 * rf, _triangle.p2 * rf);
+	const omm::StatelessRasterizer rasterizer(t);
+	const omm::raster::CoverageMaskFn coverageMask = omm::raster::GetCoverageMaskFn();
+
+	for (omm::raster::EdgeSetup edges : {
+		omm::GetConservativeEdgeSetup<omm::RasterMode::OverConservative>(rasterizer, float2(1, 1)),
+		omm::GetConservativeEdgeSetup<omm::RasterMode::UnderConservative>(rasterizer, float2(1, 1)) }) {
+		for (int y = -3; y < _size.y + 3; y += 7) {
+			for (uint32_t count : { 1u, 7u, 8u, 33u, 64u }) {
+				for (int x = -3; x < _size.x; x += 61) {
+					EXPECT_EQ(coverageMask(edges, x, y, count), omm::raster::CoverageMaskScalar(edges, x, y, count));
+				}
+			}
+		}
+	}
+}
+
+TEST_P(RasterTest, RasterizeConservativeTiled) {
+	auto Less = [](const int2& a, const int2& b) { return a.y < b.y || (a.y == b.y && a.x < b.x); };
+
+	std::vector<int2> expected;
+	omm::RasterizeConservativeSerial(_triangle, _size, [&expected](int2 idx, void*) { expected.push_back(idx); });
+
+	std::vector<int2> inside;
+	omm::RasterizeUnderConservative(_triangle, _size, [&inside](int2 idx, void*) { inside.push_back(idx); });
+	std::sort(inside.begin(), inside.end(), Less);
+
+	std::vector<int2> visited;
+	uint32_t numTiles = 0;
+	omm::RasterizeConservativeTiledImpl<omm::RasterMode::UnderConservative>(_triangle, _size, float2(0, 0),
+		[&visited](int2 idx, void*) { visited.push_back(idx); },
+		[&](int2 tileMin, int2 tileMax, void*) {
+			numTiles++;
+			for (int y = tileMin.y; y <= tileMax.y; ++y) {
+				for (int x = tileMin.x; x <= tileMax.x; ++x) {
+					EXPECT_TRUE(std::binary_search(inside.begin(), inside.end(), int2(x, y), Less));
+					visited.push_back(int2(x, y));
+				}
+			}
+			return omm::TileResult::Handled;
+		});
+
+	std::sort(expected.begin(), expected.end(), Less);
+	std::sort(visited.begin(), visited.end(), Less);
+	EXPECT_EQ(visited, expected);
+	EXPECT_LE(numTiles * omm::kRasterTileSize * omm::kRasterTileSize, (uint32_t)inside.size());
+}
+
+TEST_P(RasterTest, RasterizeConservativeTiledCoverage) {
+	auto Less = [](const int2& a, const int2& b) { return a.y < b.y || (a.y == b.y && a.x < b.x); };
+
+	std::vector<int2> expected;
+	omm::RasterizeConservativeSerial(_triangle, _size, [&expected](int2 idx, void*) { expected.push_back(idx); });
+
+	// Every other tile is left to the pixel kernel.
+	std::vector<int2> visited;
+	uint32_t numTiles = 0;
+	omm::RasterizeConservativeSerialWithOffsetTiled(_triangle, _size, float2(0, 0),
+		[&visited](int2 idx, void*) { visited.push_back(idx); },
+		[&](int2 tileMin, int2 tileMax, uint64_t coverage, void*) {
+			EXPECT_NE(coverage, 0ull);
+			EXPECT_EQ(tileMax - tileMin, int2(omm::kRasterTileSize - 1));
+			if ((numTiles++ & 1) == 0)
+				return omm::TileResult::PerPixel;
+			for (; coverage != 0; coverage &= coverage - 1) {
+				const int bit = std::countr_zero(coverage);
+				visited.push_back(tileMin + int2(bit % omm::kRasterTileSize, bit / omm::kRasterTileSize));
+			}
+			return omm::TileResult::Handled;
+		});
+
+	std::sort(expected.begin(), expected.end(), Less);
+	std::sort(visited.begin(), visited.end(), Less);
+	EXPECT_EQ(visited, expected);
+}
+
+struct ProceduralAlphaParams {
+	uint32_t* numAbove;
+	uint32_t* numBelow;
+	float alphaCutoff;
+};
+
+// Stand-in for a texture fetch, cheap enough that the call overhead of the kernel is visible.
+bool ProceduralAlphaEval(int2 pixel, const ProceduralAlphaParams* p) {
+	const uint32_t h = ((uint32_t)pixel.x * 73856093u) ^ ((uint32_t)pixel.y * 19349663u);
+	const float alpha = (float)(h & 0xFFFFu) * (1.f / 65535.f);
+	const bool isAbove = p->alphaCutoff < alpha;
+	*p->numAbove += isAbove;
+	*p->numBelow += !isAbove;
+	return true;
+}
+
+bool ProceduralAlphaRun(int2 pixel, void* ctx) {
+	return ProceduralAlphaEval(pixel, (const ProceduralAlphaParams*)ctx);
+}
+
+struct ProceduralAlphaFunctor {
+	ProceduralAlphaParams params;
+	bool operator()(int2 pixel, void*) const { return ProceduralAlphaEval(pixel, &params); }
+};
+
+TEST(RasterKernel, FunctionPointerMatchesFunctor) {
+	const omm::Triangle t({ 0.05f, 0.05f }, { 0.95f, 0.1f }, { 0.1f, 0.95f });
+	const int2 size = { 256, 256 };
+
+	uint32_t ptrAbove = 0, ptrBelow = 0;
+	ProceduralAlphaParams ptrParams = { &ptrAbove, &ptrBelow, 0.5f };
+	omm::RasterizeConservativeSerial(t, size, &ProceduralAlphaRun, &ptrParams);
+
+	uint32_t functorAbove = 0, functorBelow = 0;
+	const ProceduralAlphaFunctor functor = { { &functorAbove, &functorBelow, 0.5f } };
+	omm::RasterizeConservativeSerial(t, size, functor);
+
+	EXPECT_GT(ptrAbove + ptrBelow, 0u);
+	EXPECT_EQ(ptrAbove, functorAbove);
+	EXPECT_EQ(ptrBelow, functorBelow);
+}
+
+// Timing only, run with --gtest_also_run_disabled_tests.
+TEST(RasterKernel, DISABLED_FunctionPointerVsFunctorBenchmark) {
+	const omm::Triangle t({ 0.05f, 0.05f }, { 0.95f, 0.1f }, { 0.1f, 0.95f });
+	const int2 size = { 2048, 2048 };
+	const uint32_t numIterations = 8;
+
+	auto Measure = [&](auto&& rasterize) {
+		const auto start = std::chrono::high_resolution_clock::now();
+		for (uint32_t i = 0; i < numIterations; ++i)
+			rasterize();
+		return std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+	};
+
+	uint32_t ptrAbove = 0, ptrBelow = 0;
+	ProceduralAlphaParams ptrParams = { &ptrAbove, &ptrBelow, 0.5f };
+	const double ptrNs = Measure([&]() {
+		omm::RasterizeConservativeSerial(t, size, &ProceduralAlphaRun, &ptrParams);
+	});
+
+	uint32_t functorAbove = 0, functorBelow = 0;
+	const ProceduralAlphaFunctor functor = { { &functorAbove, &functorBelow, 0.5f } };
+	const double functorNs = Measure([&]() {
+		omm::RasterizeConservativeSerial(t, size, functor);
+	});
+
+	const double numTexels = (double)(ptrAbove + ptrBelow);
+	ASSERT_GT(numTexels, 0.0);
+	printf("[ RasterKernel ] function pointer: %.3f ns/texel, functor: %.3f ns/texel\n", ptrNs / numTexels, functorNs / numTexels);
+}
+
 INSTANTIATE_TEST_SUITE_P(
 	RasterContained,
 	RasterTest,
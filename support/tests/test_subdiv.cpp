@@ -402,4 +402,23 @@ namespace {
 		SubdivideTrianlge("Rot", omm::Triangle(float2(0.675f, 0.05f), float2(0.125f, 0.985f), float2(0.675f, 0.985f)));
 	}
 
+	TEST(SubdivideTriangle, MicroTriangleIterator) {
+		const omm::Triangle t(float2(0.675f, 0.05f), float2(0.125f, 0.985f), float2(0.675f, 0.985f));
+
+		for (uint32_t subdivisionLevel = 0; subdivisionLevel <= 8; ++subdivisionLevel) {
+			const uint32_t numMicroTris = omm::bird::GetNumMicroTriangles(subdivisionLevel);
+			for (uint32_t begin : { 0u, numMicroTris / 4, numMicroTris / 4 + numMicroTris / 16 }) {
+				omm::bird::MicroTriangleIterator it(t, begin, subdivisionLevel);
+				for (uint32_t i = begin; i < numMicroTris; ++i, it.Next()) {
+					const omm::Triangle expected = omm::bird::GetMicroTriangle(t, i, subdivisionLevel);
+					const omm::Triangle actual = it.GetTriangle();
+					ASSERT_EQ(it.GetIndex(), i);
+					ASSERT_EQ(actual.p0, expected.p0);
+					ASSERT_EQ(actual.p1, expected.p1);
+					ASSERT_EQ(actual.p2, expected.p2);
+				}
+			}
+		}
+	}
+
 }  // namespace
\ No newline at end of file